@@ -0,0 +1,35 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 ImpactX contributors
+# License: BSD-3-Clause-LBNL
+#
+
+
+import numpy as np
+import pandas as pd
+
+# reduced beam characteristics of each ensemble member
+rbc = [
+    pd.read_csv(f"diags/member_{k}/reduced_beam_characteristics.0", delimiter=r"\s+")
+    for k in range(2)
+]
+
+# initial state and one line per slice step
+for member in rbc:
+    assert len(member) == 1 + 3
+
+# member 1 overwrites drift2.ds = 0.5 with 1.0
+s_ref = [0.25 + 1.0 + 0.5, 0.25 + 1.0 + 1.0]
+for k, member in enumerate(rbc):
+    print(f"member {k}: s = {member['s'].iloc[-1]}")
+    assert np.isclose(member["s"].iloc[-1], s_ref[k], rtol=1.0e-12, atol=0)
+
+# the members sample their beams with different random numbers
+initial = [member.iloc[0] for member in rbc]
+for column in ["x_mean", "y_mean", "px_mean", "py_mean"]:
+    print(f"{column}: {initial[0][column]} vs. {initial[1][column]}")
+    assert initial[0][column] != initial[1][column], column
+
+# ... of the same distribution
+for column in ["sig_x", "sig_y", "sig_px", "sig_py"]:
+    assert np.isclose(initial[0][column], initial[1][column], rtol=0.05, atol=0), column
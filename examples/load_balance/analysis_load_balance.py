@@ -0,0 +1,24 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 ImpactX contributors
+# License: BSD-3-Clause-LBNL
+#
+
+
+import numpy as np
+import pandas as pd
+
+# reduced beam characteristics of the initial state and each slice step
+rbc = pd.read_csv("diags/reduced_beam_characteristics.0", delimiter=r"\s+")
+assert len(rbc) == 1 + 3
+
+# moving particles between MPI ranks does not change the beam:
+# only the order of the sums over particles may change
+initial = rbc.iloc[0]
+for step in range(1, len(rbc)):
+    final = rbc.iloc[step]
+    for column in rbc.columns:
+        if column in ["step", "s"]:
+            continue
+        print(f"{column}: {initial[column]} -> {final[column]}")
+        assert np.isclose(final[column], initial[column], rtol=1.0e-10, atol=0), column
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 ImpactX contributors
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import numpy as np
+
+import amrex.space3d as amr
+from impactx import Config, ImpactX, elements
+
+sim = ImpactX()
+
+# set numerical parameters and IO control
+sim.particle_shape = 2  # B-spline order
+sim.space_charge = False
+sim.slice_step_diagnostics = True
+sim.load_balance_intervals = 1
+sim.load_balance_threshold = 1.2
+
+# domain decomposition & space charge mesh
+sim.init_grids()
+
+comm = None
+rank = 0
+if Config.have_mpi:
+    from mpi4py import MPI
+
+    comm = MPI.Comm.f2py(sim.mpi_comm_f)
+    rank = comm.Get_rank()
+
+# 2 GeV electrons
+pc = sim.particle_container()
+ref = pc.ref_particle()
+ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(2.0e3)
+
+# all particles start on the first MPI rank: maximal imbalance
+npart = 10000
+rng = np.random.default_rng(seed=42)
+mean = [1.0e-4, -2.0e-4, 3.0e-4, 1.0e-5, 2.0e-5, 1.0e-4]
+sigma = [1.0e-3, 2.0e-3, 3.0e-3, 1.0e-4, 2.0e-4, 1.0e-3]
+coords = [rng.normal(m, sig, npart) for m, sig in zip(mean, sigma)]
+if rank != 0:
+    coords = [np.zeros(0)] * 6
+
+podvs = []
+for values in coords:
+    if Config.have_gpu:
+        podv = amr.PODVector_real_arena()
+    else:
+        podv = amr.PODVector_real_std()
+    podv.resize(values.size)
+    if values.size > 0:
+        if Config.have_gpu:
+            podv.to_cupy()[:] = values
+        else:
+            podv.to_numpy()[:] = values
+    podvs.append(podv)
+qm_eev = ref.charge_qe / (ref.mass_MeV * 1.0e6)
+pc.add_n_particles(*podvs, qm_eev, 1.0e-9)
+
+# elements that do not change the beam: only the load balancing moves particles
+sim.lattice.extend([elements.Empty(), elements.Empty(), elements.Empty()])
+
+# run simulation
+sim.track_particles()
+
+# the particles are now spread over all MPI ranks
+assert pc.total_number_of_particles() == npart
+if comm is not None:
+    local = pc.total_number_of_particles(only_valid=True, only_local=True)
+    counts = comm.allgather(local)
+    assert sum(counts) == npart
+    assert max(counts) <= 1.2 * npart / len(counts), counts
+
+# clean shutdown
+sim.finalize()
@@ -8,18 +8,31 @@
  * License: BSD-3-Clause-LBNL
  */
 #include "ImpactX.H"
+#include "initialization/Ensemble.H"
 #include "initialization/InitAmrCore.H"
 #include "initialization/InitDistribution.H"
+#include "initialization/NUMA.H"
+#include "initialization/SimplifyLattice.H"
+#include "particles/Autotune.H"
 #include "particles/CollectLost.H"
 #include "particles/ImpactXParticleContainer.H"
+#include "particles/LoadBalance.H"
 #include "particles/Push.H"
+#include "particles/RefOrbitCache.H"
+#include "particles/ScratchMemory.H"
 #include "particles/diagnostics/DiagnosticOutput.H"
+#include "particles/diagnostics/HaloCharacteristics.H"
+#include "particles/diagnostics/Histogram.H"
+#include "particles/diagnostics/ProbeParticles.H"
+#include "particles/diagnostics/ReducedBeamCharacteristics.H"
 #include "particles/spacecharge/ForceFromSelfFields.H"
 #include "particles/spacecharge/GatherAndPush.H"
 #include "particles/spacecharge/PoissonSolve.H"
 #include "particles/transformation/CoordinateTransformation.H"
 #include "particles/wakefields/HandleWakefield.H"
 
+#include <ablastr/warn_manager/WarnManager.H>
+
 #include <AMReX.H>
 #include <AMReX_AmrParGDB.H>
 #include <AMReX_BLProfiler.H>
@@ -30,6 +43,11 @@
 
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 
 namespace impactx {
@@ -51,6 +69,16 @@ namespace impactx {
         {
             m_lattice.clear();
 
+            // report and free reused per-step buffers
+            int verbose = 1;
+            amrex::ParmParse("impactx").queryAdd("verbose", verbose);
+            if (verbose > 0) {
+                scratch::report();
+                ref_orbit_cache::report();
+            }
+            scratch::release_all();
+            ref_orbit_cache::set_enabled(false);
+
             // this one last
             amr_data.reset();
 
@@ -77,7 +105,7 @@ namespace impactx {
         bool diag_enable = true;
         amrex::ParmParse("diag").queryAdd("enable", diag_enable);
         if (diag_enable) {
-            amrex::UtilCreateCleanDirectory("diags", true);
+            amrex::UtilCreateCleanDirectory(initialization::diags_directory(), true);
         }
 
         // the particle container has been set to track the same Geometry as ImpactX
@@ -90,12 +118,17 @@ namespace impactx {
         amr_data->InitFromScratch(0.0);
 
         // alloc particle containers
-        //   the lost particles have an extra runtime attribute: s when it was lost
+        //   the lost particles have extra runtime attributes: s and period (turn) when it was lost
         if (!amr_data->m_particles_lost->HasRealComp("s_lost"))
         {
             bool comm = true;
             amr_data->m_particles_lost->AddRealComp("s_lost", comm);
         }
+        if (!amr_data->m_particles_lost->HasRealComp("period_lost"))
+        {
+            bool comm = true;
+            amr_data->m_particles_lost->AddRealComp("period_lost", comm);
+        }
 
         //   have to resize here, not in the constructor because grids have not
         //   been built when constructor was called.
@@ -120,6 +153,13 @@ namespace impactx {
             }
         }
 
+        // optional: report where the OpenMP threads of each rank run
+        bool report_affinity = false;
+        amrex::ParmParse("impactx").queryAdd("report_affinity", report_affinity);
+        if (report_affinity) {
+            initialization::report_thread_affinity();
+        }
+
         // keep track that init is done
         m_grids_initialized = true;
     }
@@ -137,6 +177,22 @@ namespace impactx {
 
         validate();
 
+        // detect a common qm and w of all beam particles, used by diagnostics and I/O
+        amr_data->m_particle_container->UpdateUniformAttributes();
+
+        // phase space coordinates pushed in beam optics elements
+        amr_data->m_particle_container->SetTrackingDimensions();
+
+        // OpenMP work sharing on particle tiles, optionally autotuned on a copy of the beam
+        amr_data->m_particle_container->SetTileThreading();
+        bool do_autotune = false;
+        amrex::ParmParse("impactx").queryAdd("autotune", do_autotune);
+        if (do_autotune) {
+            int autotune_pushes = 5;
+            amrex::ParmParse("impactx").queryAdd("autotune_pushes", autotune_pushes);
+            autotune(*amr_data->m_particle_container, amr_data.get(), autotune_pushes);
+        }
+
         // verbosity
         amrex::ParmParse pp_impactx("impactx");
         int verbose = 1;
@@ -156,6 +212,15 @@ namespace impactx {
             amrex::Print() << " Diagnostics: " << diag_enable << "\n";
         }
 
+        // number of steps for which reduced beam characteristics are
+        // accumulated per MPI rank before one collective reduction and write
+        int batch_reductions = 1;
+        pp_diag.queryAdd("batch_reductions", batch_reductions);
+        std::optional<diagnostics::BatchedReducedBeamCharacteristics> batched_rbc;
+
+        // trajectories of a few probe particles, selected once at the start
+        std::optional<diagnostics::ProbeParticles> probes;
+
         int file_min_digits = 6;
         if (diag_enable)
         {
@@ -164,16 +229,48 @@ namespace impactx {
             // print initial reference particle to file
             diagnostics::DiagnosticOutput(*amr_data->m_particle_container,
                                           diagnostics::OutputType::PrintRefParticle,
-                                          "diags/ref_particle",
+                                          initialization::diags_directory() + "/ref_particle",
                                           step);
 
             // print the initial values of reduced beam characteristics
-            diagnostics::DiagnosticOutput(*amr_data->m_particle_container,
-                                          diagnostics::OutputType::PrintReducedBeamCharacteristics,
-                                          "diags/reduced_beam_characteristics");
+            if (batch_reductions > 1) {
+                batched_rbc.emplace(initialization::diags_directory() + "/reduced_beam_characteristics", batch_reductions);
+                (*batched_rbc)(*amr_data->m_particle_container, step);
+            } else {
+                diagnostics::DiagnosticOutput(*amr_data->m_particle_container,
+                                              diagnostics::OutputType::PrintReducedBeamCharacteristics,
+                                              initialization::diags_directory() + "/reduced_beam_characteristics");
+            }
 
+            // print the initial phase space histograms, if requested
+            diagnostics::HistogramOutput(*amr_data->m_particle_container, step, false);
+
+            // print the initial halo characteristics, if requested
+            diagnostics::HaloOutput(*amr_data->m_particle_container, step, false);
+
+            // select probe particles by id or by largest amplitude, if requested
+            std::vector<amrex::Long> probe_ids;
+            pp_diag.queryarr("probe_ids", probe_ids);
+            std::vector<uint64_t> probe_idcpu;
+            if (!probe_ids.empty()) {
+                probe_idcpu = diagnostics::find_idcpu(*amr_data->m_particle_container, probe_ids);
+            }
+            int probe_largest_amplitude = 0;
+            pp_diag.queryAdd("probe_largest_amplitude", probe_largest_amplitude);
+            if (probe_largest_amplitude > 0) {
+                auto const largest = diagnostics::largest_amplitude_idcpu(*amr_data->m_particle_container,
+                                                                          probe_largest_amplitude);
+                probe_idcpu.insert(probe_idcpu.end(), largest.begin(), largest.end());
+            }
+            if (!probe_idcpu.empty()) {
+                probes.emplace(initialization::diags_directory() + "/probe_particles", probe_idcpu);
+                (*probes)(*amr_data->m_particle_container, step);
+            }
         }
 
+        // in-memory history of the initial values, if requested
+        record_history(step);
+
         amrex::ParmParse pp_algo("algo");
         bool space_charge = false;
         pp_algo.query("space_charge", space_charge);
@@ -181,16 +278,52 @@ namespace impactx {
             amrex::Print() << " Space Charge effects: " << space_charge << "\n";
         }
 
+        // maximum number of cells particles move in a slice step, for neighbor-only redistribution
+        int local_redistribute = 0;
+        pp_algo.queryAdd("local_redistribute", local_redistribute);
+
         bool csr = false;
         pp_algo.query("csr", csr);
         if (verbose > 0) {
             amrex::Print() << " CSR effects: " << csr << "\n";
         }
 
+        // remove no-op elements and merge adjacent drifts and thin kicks, if requested
+        bool simplify = false;
+        amrex::ParmParse("lattice").queryAdd("simplify", simplify);
+        if (simplify) {
+            // probe particles are also recorded at every slice step
+            bool slice_step_diagnostics = false;
+            pp_diag.queryAdd("slice_step_diagnostics", slice_step_diagnostics);
+            initialization::simplify_lattice(m_lattice, space_charge || csr,
+                                             slice_step_diagnostics || probes.has_value(), verbose);
+        }
+
+        // replay reference particle pushes of integrated elements from earlier periods and tracking calls
+        bool cache_reference_orbit = false;
+        pp_algo.queryAdd("cache_reference_orbit", cache_reference_orbit);
+        ref_orbit_cache::set_enabled(cache_reference_orbit);
+
         // periods through the lattice
         int num_periods = 1;
         amrex::ParmParse("lattice").queryAdd("periods", num_periods);
 
+        // stop early if all particles are lost, e.g., in dynamic aperture scans
+        bool stop_when_all_lost = false;
+        amrex::ParmParse("lattice").queryAdd("stop_when_all_lost", stop_when_all_lost);
+
+        // even out the particles per MPI rank after losses, tracking without space charge only
+        int load_balance_intervals = 0;
+        amrex::Real load_balance_threshold = 1.2;
+        pp_algo.queryAdd("load_balance_intervals", load_balance_intervals);
+        pp_algo.queryAdd("load_balance_threshold", load_balance_threshold);
+        if (load_balance_intervals > 0 && space_charge) {
+            ablastr::warn_manager::WMRecordWarning(
+                "ImpactX::track_particles",
+                "algo.load_balance_intervals is ignored with space charge.",
+                ablastr::warn_manager::WarnPriority::low);
+        }
+
         for (int period=0; period < num_periods; ++period) {
             // loop over all beamline elements
             for (auto &element_variant: m_lattice) {
@@ -230,10 +363,15 @@ namespace impactx {
                         // the particles are in x, y, z coordinates.
 
                         // Resize the mesh, based on `m_particle_container` extent
-                        ResizeMesh();
+                        bool const mesh_changed = ResizeMesh();
 
-                        // Redistribute particles in the new mesh in x, y, z
-                        amr_data->m_particle_container->Redistribute();
+                        // Redistribute particles in the new mesh in x, y, z:
+                        //   if the mesh did not change, optionally only with neighboring boxes
+                        int const local = mesh_changed ? 0 : local_redistribute;
+                        amr_data->m_particle_container->Redistribute(0, -1, 0, local);
+
+                        // fields, e.g., if space charge was enabled after init_grids
+                        amr_data->AllocateFields();
 
                         // charge deposition
                         amr_data->m_particle_container->DepositCharge(amr_data->m_rho, amr_data->refRatio());
@@ -273,7 +411,14 @@ namespace impactx {
                     Push(*amr_data->m_particle_container, element_variant, step, period);
 
                     // move "lost" particles to another particle container
-                    collect_lost_particles(*amr_data->m_particle_container);
+                    collect_lost_particles(*amr_data->m_particle_container, period);
+
+                    if (load_balance_intervals > 0 && !space_charge && step % load_balance_intervals == 0) {
+                        bool const moved = rebalance_particles(*amr_data->m_particle_container, load_balance_threshold);
+                        if (moved && verbose > 0) {
+                            amrex::Print() << " Rebalanced particles across MPI ranks\n";
+                        }
+                    }
 
                     // just prints an empty newline at the end of the slice_step
                     if (verbose > 0) {
@@ -288,41 +433,86 @@ namespace impactx {
                         // print slice step reference particle to file
                         diagnostics::DiagnosticOutput(*amr_data->m_particle_container,
                                                       diagnostics::OutputType::PrintRefParticle,
-                                                      "diags/ref_particle",
+                                                      initialization::diags_directory() + "/ref_particle",
                                                       step,
                                                       true);
 
                         // print slice step reduced beam characteristics to file
-                        diagnostics::DiagnosticOutput(*amr_data->m_particle_container,
-                                                      diagnostics::OutputType::PrintReducedBeamCharacteristics,
-                                                      "diags/reduced_beam_characteristics",
-                                                      step,
-                                                      true);
-
+                        if (batched_rbc) {
+                            (*batched_rbc)(*amr_data->m_particle_container, step);
+                        } else {
+                            diagnostics::DiagnosticOutput(*amr_data->m_particle_container,
+                                                          diagnostics::OutputType::PrintReducedBeamCharacteristics,
+                                                          initialization::diags_directory() + "/reduced_beam_characteristics",
+                                                          step,
+                                                          true);
+                        }
+
+                        // print slice step phase space histograms, if requested
+                        diagnostics::HistogramOutput(*amr_data->m_particle_container, step, true);
+
+                        // print slice step halo characteristics, if requested
+                        diagnostics::HaloOutput(*amr_data->m_particle_container, step, true);
                     }
 
+                    // probe particles are recorded at every slice step
+                    if (probes) { (*probes)(*amr_data->m_particle_container, step); }
+
+                    // in-memory history of slice step values, if requested
+                    if (slice_step_diagnostics) { record_history(step); }
+
                     // inputs: unused parameters (e.g. typos) check after step 1 has finished
                     if (!early_params_checked) { early_params_checked = early_param_check(); }
 
                 } // end in-element space-charge slice-step loop
 
             } // end beamline element loop
+
+            if (stop_when_all_lost &&
+                amr_data->m_particle_container->TotalNumberOfParticles(true, false) == 0)
+            {
+                amrex::Print() << " All particles lost in period " << period
+                               << ", stopping the tracking.\n";
+                break;
+            }
         } // end periods though the lattice loop
 
+        // in-memory history of the final values, unless already recorded in the last slice step
+        {
+            bool slice_step_diagnostics = false;
+            pp_diag.queryAdd("slice_step_diagnostics", slice_step_diagnostics);
+            if (!slice_step_diagnostics) { record_history(step); }
+        }
+
         if (diag_enable)
         {
+            // write remaining batched reduced beam characteristics
+            if (batched_rbc) { batched_rbc->flush(); }
+
+            // write the trajectories of the probe particles
+            if (probes) { probes->write(); }
+
             // print final reference particle to file
             diagnostics::DiagnosticOutput(*amr_data->m_particle_container,
                                           diagnostics::OutputType::PrintRefParticle,
-                                          "diags/ref_particle_final",
+                                          initialization::diags_directory() + "/ref_particle_final",
                                           step);
 
             // print the final values of the reduced beam characteristics
             diagnostics::DiagnosticOutput(*amr_data->m_particle_container,
                                           diagnostics::OutputType::PrintReducedBeamCharacteristics,
-                                          "diags/reduced_beam_characteristics_final",
+                                          initialization::diags_directory() + "/reduced_beam_characteristics_final",
                                           step);
 
+            // print the final phase space histograms and halo characteristics,
+            // unless already written in the last slice step
+            bool slice_step_diagnostics = false;
+            pp_diag.queryAdd("slice_step_diagnostics", slice_step_diagnostics);
+            if (!slice_step_diagnostics) {
+                diagnostics::HistogramOutput(*amr_data->m_particle_container, step, true);
+                diagnostics::HaloOutput(*amr_data->m_particle_container, step, true);
+            }
+
             // output particles lost in apertures
             if (amr_data->m_particles_lost->TotalNumberOfParticles() > 0)
             {
@@ -343,4 +533,40 @@ namespace impactx {
             }, element_variant);
         }
     }
+
+    void ImpactX::record_history (int step)
+    {
+        amrex::ParmParse pp_diag("diag");
+        std::vector<std::string> quantities;
+        pp_diag.queryarr("history", quantities);
+        if (quantities.empty()) { return; }
+
+        BL_PROFILE("ImpactX::record_history");
+
+        // from the cached beam moments: no extra pass if diagnostics were just written
+        auto const rbc = diagnostics::reduced_beam_characteristics(*amr_data->m_particle_container).to_map();
+
+        // expand "all" and record each quantity once, even if requested repeatedly
+        std::set<std::string> unique_quantities;
+        for (auto const & quantity : quantities) {
+            if (quantity == "all") {
+                for (auto const & [key, value] : rbc) { unique_quantities.insert(key); }
+            } else {
+                unique_quantities.insert(quantity);
+            }
+        }
+        // always recorded
+        unique_quantities.erase("step");
+        unique_quantities.erase("s");
+
+        m_history["step"].push_back(step);
+        m_history["s"].push_back(amr_data->m_particle_container->GetRefParticle().s);
+        for (auto const & quantity : unique_quantities) {
+            auto const it = rbc.find(quantity);
+            if (it == rbc.end()) {
+                throw std::runtime_error("diag.history: unknown quantity " + quantity);
+            }
+            m_history[quantity].push_back(it->second);
+        }
+    }
 } // namespace impactx
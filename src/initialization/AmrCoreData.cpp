@@ -12,6 +12,7 @@
 #include "initialization/InitMeshRefinement.H"
 
 #include <AMReX.H>
+#include <AMReX_ParmParse.H>
 
 
 namespace impactx::initialization
@@ -117,6 +118,31 @@ namespace impactx::initialization
     {
         amrex::ignore_unused(time);
 
+        // fields are only needed for space charge, see AllocateFields
+        bool space_charge = false;
+        amrex::ParmParse("algo").query("space_charge", space_charge);
+        if (space_charge) {
+            AllocateFields(lev, ba, dm);
+        }
+    }
+
+    void
+    AmrCoreData::AllocateFields ()
+    {
+        for (int lev = 0; lev <= finestLevel(); ++lev)
+        {
+            if (m_rho.count(lev) == 0) {
+                AllocateFields(lev, boxArray(lev), DistributionMap(lev));
+            }
+        }
+    }
+
+    void
+    AmrCoreData::AllocateFields (
+        int lev,
+        const amrex::BoxArray& ba,
+        const amrex::DistributionMapping& dm)
+    {
         // set human-readable tag for each MultiFab
         auto const tag = [lev]( std::string tagname ) {
             tagname.append("[l=").append(std::to_string(lev)).append("]");
@@ -0,0 +1,190 @@
+/* Copyright 2022-2024 The Regents of the University of California, through Lawrence
+ *           Berkeley National Laboratory (subject to receipt of any required
+ *           approvals from the U.S. Dept. of Energy). All rights reserved.
+ *
+ * This file is part of ImpactX.
+ *
+ * Authors: Axel Huebl
+ * License: BSD-3-Clause-LBNL
+ */
+#include "DomainDecomposition.H"
+
+#include <AMReX_BLProfiler.H>
+#include <AMReX_BoxArray.H>
+#include <AMReX_BoxList.H>
+#include <AMReX_DistributionMapping.H>
+#include <AMReX_GpuAtomic.H>
+#include <AMReX_GpuContainers.H>
+#include <AMReX_GpuLaunch.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParallelReduce.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace impactx::initialization
+{
+    bool
+    balanced_decomposition ()
+    {
+        std::string domain_decomposition = "default";
+        amrex::ParmParse("amr").queryAdd("domain_decomposition", domain_decomposition);
+        if (domain_decomposition != "default" && domain_decomposition != "balanced") {
+            throw std::runtime_error("amr.domain_decomposition must be default or balanced but is: " + domain_decomposition);
+        }
+        return domain_decomposition == "balanced";
+    }
+
+    amrex::IntVect
+    factor_ranks (int nprocs)
+    {
+        // prime factors, largest first
+        std::vector<int> primes;
+        for (int p = 2; p * p <= nprocs; ++p) {
+            while (nprocs % p == 0) {
+                primes.push_back(p);
+                nprocs /= p;
+            }
+        }
+        if (nprocs > 1) { primes.push_back(nprocs); }
+        std::sort(primes.begin(), primes.end(), std::greater<>());
+
+        // multiply each into the currently smallest direction
+        amrex::IntVect boxes(1);
+        for (int const p : primes) {
+            int const dir = static_cast<int>(std::min_element(boxes.begin(), boxes.end()) - boxes.begin());
+            boxes[dir] *= p;
+        }
+        return boxes;
+    }
+
+    bool
+    balance_domain_decomposition (AmrCoreData & amr_data)
+    {
+        BL_PROFILE("impactx::initialization::balance_domain_decomposition");
+
+        if (amr_data.finestLevel() > 0) {
+            throw std::runtime_error("amr.domain_decomposition = balanced is not yet implemented for mesh-refinement.");
+        }
+
+        amrex::ParmParse pp_amr("amr");
+        int boxes_per_rank = 4;
+        pp_amr.queryAdd("boxes_per_rank", boxes_per_rank);
+        amrex::Real cell_weight = 1.0;
+        pp_amr.queryAdd("cell_weight", cell_weight);
+
+        amrex::Geometry const & geom = amr_data.Geom(0);
+        amrex::Box const domain = geom.Domain();
+        amrex::IntVect const n_cell = domain.length();
+        amrex::IntVect const bf = amr_data.blockingFactor(0);
+        amrex::IntVect const max_grid_size = amr_data.maxGridSize(0);
+
+        // boxes per direction: split the longest direction until there are enough boxes
+        auto const box_size = [&](int dir, int nboxes) {
+            int const nblocks = (n_cell[dir] + bf[dir] - 1) / bf[dir];
+            return bf[dir] * ((nblocks + nboxes - 1) / nboxes);
+        };
+        amrex::IntVect nboxes(1);
+        amrex::IntVect size = n_cell;
+        amrex::Long const min_boxes = amrex::Long(boxes_per_rank) * amrex::ParallelDescriptor::NProcs();
+        while (true) {
+            int split = -1;
+            for (int dir = 0; dir < AMREX_SPACEDIM; ++dir) {
+                if (size[dir] > max_grid_size[dir] && (split < 0 || size[dir] > size[split])) { split = dir; }
+            }
+            if (split < 0 && nboxes.d_numPts() < min_boxes) {
+                for (int dir = 0; dir < AMREX_SPACEDIM; ++dir) {
+                    if (size[dir] > bf[dir] && (split < 0 || size[dir] > size[split])) { split = dir; }
+                }
+            }
+            if (split < 0) { break; }
+
+            int n = nboxes[split];
+            while (box_size(split, n) == size[split]) { ++n; }
+            size[split] = box_size(split, n);
+            nboxes[split] = (n_cell[split] + size[split] - 1) / size[split];
+        }
+
+        // regular boxes, x fastest
+        amrex::BoxList bl;
+        for (int k = 0; k < nboxes[2]; ++k) {
+            for (int j = 0; j < nboxes[1]; ++j) {
+                for (int i = 0; i < nboxes[0]; ++i) {
+                    amrex::IntVect const lo = domain.smallEnd() + amrex::IntVect(i, j, k) * size;
+                    amrex::IntVect const hi = amrex::min(lo + size - 1, domain.bigEnd());
+                    bl.push_back(amrex::Box(lo, hi));
+                }
+            }
+        }
+        amrex::BoxArray const ba(std::move(bl));
+        int const num_boxes = static_cast<int>(ba.size());
+
+        // cost per box: particles in the box
+        amrex::Gpu::DeviceVector<amrex::Real> d_cost(num_boxes, 0.0);
+        {
+            amrex::Real * const AMREX_RESTRICT cost = d_cost.dataPtr();
+            auto const plo = geom.ProbLoArray();
+            auto const dxi = geom.InvCellSizeArray();
+            amrex::GpuArray<int, 3> const n = {n_cell[0], n_cell[1], n_cell[2]};
+            amrex::GpuArray<int, 3> const s = {size[0], size[1], size[2]};
+            amrex::GpuArray<int, 3> const nb = {nboxes[0], nboxes[1], nboxes[2]};
+
+            auto & pc = *amr_data.m_particle_container;
+            for (auto & [index, ptile] : pc.GetParticles(0)) {
+                auto & soa = ptile.GetStructOfArrays();
+                amrex::ParticleReal const * const AMREX_RESTRICT x = soa.GetRealData(RealSoA::x).dataPtr();
+                amrex::ParticleReal const * const AMREX_RESTRICT y = soa.GetRealData(RealSoA::y).dataPtr();
+                amrex::ParticleReal const * const AMREX_RESTRICT z = soa.GetRealData(RealSoA::z).dataPtr();
+
+                amrex::ParallelFor(ptile.numParticles(), [=] AMREX_GPU_DEVICE (long i) {
+                    amrex::ParticleReal const pos[3] = {x[i], y[i], z[i]};
+                    int b[3];
+                    for (int dir = 0; dir < 3; ++dir) {
+                        int const cell = static_cast<int>(std::floor((pos[dir] - plo[dir]) * dxi[dir]));
+                        b[dir] = amrex::min(amrex::max(cell, 0), n[dir] - 1) / s[dir];
+                    }
+                    amrex::Gpu::Atomic::AddNoRet(&cost[b[0] + nb[0] * (b[1] + nb[1] * b[2])], amrex::Real(1.0));
+                });
+            }
+        }
+        amrex::Vector<amrex::Real> costs(num_boxes);
+        amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, d_cost.begin(), d_cost.end(), costs.begin());
+        amrex::Gpu::streamSynchronize();
+        amrex::ParallelAllReduce::Sum(costs.data(), num_boxes, amrex::ParallelDescriptor::Communicator());
+
+        // cost per box: field work in the box
+        for (int b = 0; b < num_boxes; ++b) {
+            costs[b] += cell_weight * amrex::Real(ba[b].numPts());
+        }
+
+        amrex::Real efficiency = 0.0;
+        amrex::DistributionMapping const dm = amrex::DistributionMapping::makeSFC(costs, ba, efficiency);
+
+        if (ba == amr_data.boxArray(0) && dm == amr_data.DistributionMap(0)) { return false; }
+
+        int verbose = 1;
+        amrex::ParmParse("impactx").queryAdd("verbose", verbose);
+        if (verbose > 0) {
+            amrex::Print() << " Balanced domain decomposition: " << nboxes[0] << "x" << nboxes[1] << "x" << nboxes[2]
+                           << " boxes, efficiency " << efficiency << "\n";
+        }
+
+        // new layout for fields and particles, the particles are redistributed by the caller
+        amr_data.ClearLevel(0);
+        amr_data.SetBoxArray(0, ba);
+        amr_data.SetDistributionMap(0, dm);
+        amr_data.MakeNewLevelFromScratch(0, 0.0, ba, dm);
+
+        amr_data.m_particle_container->SetParticleBoxArray(0, ba);
+        amr_data.m_particle_container->SetParticleDistributionMap(0, dm);
+        return true;
+    }
+
+} // namespace impactx::initialization
@@ -0,0 +1,50 @@
+/* Copyright 2022-2024 The Regents of the University of California, through Lawrence
+ *           Berkeley National Laboratory (subject to receipt of any required
+ *           approvals from the U.S. Dept. of Energy). All rights reserved.
+ *
+ * This file is part of ImpactX.
+ *
+ * Authors: Axel Huebl
+ * License: BSD-3-Clause-LBNL
+ */
+#include "Ensemble.H"
+
+#include <AMReX_ParmParse.H>
+#include <AMReX_Random.H>
+
+#include <string>
+#include <vector>
+
+
+namespace impactx::initialization
+{
+    void
+    setup_ensemble_member (int member, int world_rank, int world_size)
+    {
+        amrex::ParmParse pp_ensemble("ensemble");
+        pp_ensemble.add("member", member);
+
+        // per-member inputs overwrite the common ones; inputs of other members are only marked as used
+        std::string const member_prefix = "ensemble.member" + std::to_string(member) + ".";
+        amrex::ParmParse pp;
+        for (auto const & entry : amrex::ParmParse::getEntries("ensemble")) {
+            std::vector<std::string> values;
+            pp.queryarr(entry.c_str(), values);
+            if (entry.rfind(member_prefix, 0) == 0) {
+                pp.addarr(entry.substr(member_prefix.size()).c_str(), values);
+            }
+        }
+
+        // each member would otherwise repeat the random numbers of the first member
+        auto const seed = static_cast<amrex::ULong>(world_rank) + 1;
+        amrex::InitRandom(seed, world_size, seed);
+    }
+
+    std::string
+    diags_directory ()
+    {
+        int member = -1;
+        amrex::ParmParse("ensemble").query("member", member);
+        return member < 0 ? std::string("diags") : "diags/member_" + std::to_string(member);
+    }
+} // namespace impactx::initialization
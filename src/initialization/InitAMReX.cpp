@@ -9,10 +9,12 @@
  */
 #include "InitAMReX.H"
 
+#include "initialization/Ensemble.H"
 #include "initialization/InitParser.H"
 
 #include <AMReX.H>
 #include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParmParse.H>
 
 #if defined(AMREX_USE_MPI)
 #   include <mpi.h>
@@ -20,6 +22,8 @@
 #   include <AMReX_ccse-mpi.H>
 #endif
 
+#include <stdexcept>
+
 
 namespace impactx::initialization
 {
@@ -36,6 +40,38 @@ namespace impactx::initialization
                     MPI_COMM_WORLD,
                     impactx::initialization::overwrite_amrex_parser_defaults
             );
+
+#if defined(AMREX_USE_MPI)
+            // ensemble of independent simulations: restart AMReX on one
+            // sub-communicator per simulation, split in blocks of ranks
+            int ensemble_size = 1;
+            amrex::ParmParse("ensemble").query("size", ensemble_size);
+            if (ensemble_size > 1)
+            {
+                int world_rank = 0;
+                int world_size = 1;
+                MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+                MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+                if (world_size % ensemble_size != 0)
+                    throw std::runtime_error("The number of MPI ranks must be a multiple of ensemble.size");
+
+                int const member = world_rank / (world_size / ensemble_size);
+                MPI_Comm member_comm;
+                MPI_Comm_split(MPI_COMM_WORLD, member, world_rank, &member_comm);
+
+                amrex::Finalize();
+                amrex::Initialize(
+                        argc,
+                        argv,
+                        build_parm_parse,
+                        member_comm,
+                        impactx::initialization::overwrite_amrex_parser_defaults
+                );
+                MPI_Comm_free(&member_comm);  // AMReX keeps a duplicate
+
+                setup_ensemble_member(member, world_rank, world_size);
+            }
+#endif
         }
     }
 
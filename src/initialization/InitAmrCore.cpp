@@ -9,6 +9,7 @@
  */
 #include "InitAmrCore.H"
 
+#include "initialization/DomainDecomposition.H"
 #include "initialization/InitAMReX.H"
 
 #include <AMReX_Array.H>
@@ -125,10 +126,12 @@ namespace details
             amr_info.max_grid_size = {{bf_lvl0_iv}};
         }
 
-        // Domain index space
+        // Domain index space: slabs along x, or split in all directions if balanced
         const int nprocs = amrex::ParallelDescriptor::NProcs();
-        const amrex::IntVect high_end = amr_info.blocking_factor[0]
-                                        * amrex::IntVect(AMREX_D_DECL(nprocs,1,1)) - amrex::IntVect(1);
+        amrex::IntVect const boxes = balanced_decomposition()
+                                     ? factor_ranks(nprocs)
+                                     : amrex::IntVect(AMREX_D_DECL(nprocs,1,1));
+        const amrex::IntVect high_end = amr_info.blocking_factor[0] * boxes - amrex::IntVect(1);
         amrex::Box const domain(amrex::IntVect(0), high_end);
         //   adding amr.n_cell for consistency
         auto const n_cell_iv = domain.size();
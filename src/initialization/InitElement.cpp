@@ -218,6 +218,7 @@ namespace detail
 
             amrex::ParticleReal escale, freq, phase;
             int mapsteps = mapsteps_default;
+            amrex::ParticleReal map_tolerance = 0;
             RF_field_data const ez;
             std::vector<amrex::ParticleReal> cos_coef = ez.default_cos_coef;
             std::vector<amrex::ParticleReal> sin_coef = ez.default_sin_coef;
@@ -225,10 +226,11 @@ namespace detail
             pp_element.get("freq", freq);
             pp_element.get("phase", phase);
             pp_element.queryAdd("mapsteps", mapsteps);
+            pp_element.queryAdd("map_tolerance", map_tolerance);
             detail::queryAddResize(pp_element, "cos_coefficients", cos_coef);
             detail::queryAddResize(pp_element, "sin_coefficients", sin_coef);
 
-            m_lattice.emplace_back( RFCavity(ds, escale, freq, phase, cos_coef, sin_coef, a["dx"], a["dy"], a["rotation_degree"], mapsteps, nslice, element_name) );
+            m_lattice.emplace_back( RFCavity(ds, escale, freq, phase, cos_coef, sin_coef, a["dx"], a["dy"], a["rotation_degree"], mapsteps, nslice, map_tolerance, element_name) );
         } else if (element_type == "solenoid")
         {
             auto const [ds, nslice] = detail::query_ds(pp_element, nslice_default);
@@ -260,6 +262,7 @@ namespace detail
 
             amrex::ParticleReal bscale;
             int mapsteps = mapsteps_default;
+            amrex::ParticleReal map_tolerance = 0;
             int units = 0;
             Sol_field_data const bz;
             std::vector<amrex::ParticleReal> cos_coef = bz.default_cos_coef;
@@ -267,10 +270,11 @@ namespace detail
             pp_element.get("bscale", bscale);
             pp_element.queryAdd("units", units);
             pp_element.queryAdd("mapsteps", mapsteps);
+            pp_element.queryAdd("map_tolerance", map_tolerance);
             detail::queryAddResize(pp_element, "cos_coefficients", cos_coef);
             detail::queryAddResize(pp_element, "sin_coefficients", sin_coef);
 
-            m_lattice.emplace_back( SoftSolenoid(ds, bscale, cos_coef, sin_coef, units, a["dx"], a["dy"], a["rotation_degree"], mapsteps, nslice, element_name) );
+            m_lattice.emplace_back( SoftSolenoid(ds, bscale, cos_coef, sin_coef, units, a["dx"], a["dy"], a["rotation_degree"], mapsteps, nslice, map_tolerance, element_name) );
         } else if (element_type == "quadrupole_softedge")
         {
             auto const [ds, nslice] = detail::query_ds(pp_element, nslice_default);
@@ -278,15 +282,17 @@ namespace detail
 
             amrex::ParticleReal gscale;
             int mapsteps = mapsteps_default;
+            amrex::ParticleReal map_tolerance = 0;
             Quad_field_data const gz;
             std::vector<amrex::ParticleReal> cos_coef = gz.default_cos_coef;
             std::vector<amrex::ParticleReal> sin_coef = gz.default_sin_coef;
             pp_element.get("gscale", gscale);
             pp_element.queryAdd("mapsteps", mapsteps);
+            pp_element.queryAdd("map_tolerance", map_tolerance);
             detail::queryAddResize(pp_element, "cos_coefficients", cos_coef);
             detail::queryAddResize(pp_element, "sin_coefficients", sin_coef);
 
-            m_lattice.emplace_back( SoftQuadrupole(ds, gscale, cos_coef, sin_coef, a["dx"], a["dy"], a["rotation_degree"], mapsteps, nslice, element_name) );
+            m_lattice.emplace_back( SoftQuadrupole(ds, gscale, cos_coef, sin_coef, a["dx"], a["dy"], a["rotation_degree"], mapsteps, nslice, map_tolerance, element_name) );
         } else if (element_type == "drift_chromatic")
         {
             auto const [ds, nslice] = detail::query_ds(pp_element, nslice_default);
@@ -410,6 +416,21 @@ namespace detail
             int period_sample_intervals = 1;
             pp_element.queryAdd("period_sample_intervals", period_sample_intervals);
 
+            // optional: histograms of particle attributes
+            std::vector<std::string> histograms;
+            pp_element.queryarr("histograms", histograms);
+            int histogram_bins = 64;
+            pp_element.queryAdd("histogram_bins", histogram_bins);
+
+            // optional: longitudinal slice moments
+            bool slice_moments = false;
+            pp_element.queryAdd("slice_moments", slice_moments);
+            if (slice_moments)
+            {
+                int slice_bins = 64;
+                pp_element.queryAdd("slice_bins", slice_bins);
+            }
+
             // optional: add and calculate additional particle properties
             // property: nonlinear lens invariants
             bool add_nll_invariants = false;
@@ -427,6 +448,16 @@ namespace detail
             }
 
             m_lattice.emplace_back(diagnostics::BeamMonitor(openpmd_name, openpmd_backend, openpmd_encoding, period_sample_intervals));
+        } else if (element_type == "tune_monitor")
+        {
+            std::string monitor_name = element_name;
+            pp_element.queryAdd("name", monitor_name);
+            int turns = 1024;
+            pp_element.queryAdd("turns", turns);
+            int particle_stride = 1;
+            pp_element.queryAdd("particle_stride", particle_stride);
+
+            m_lattice.emplace_back(diagnostics::TuneMonitor(monitor_name, turns, particle_stride));
         } else if (element_type == "line")
         {
             // Parse the lattice elements for the sub-lattice in the line
@@ -8,6 +8,7 @@
  * License: BSD-3-Clause-LBNL
  */
 #include "ImpactX.H"
+#include "initialization/DomainDecomposition.H"
 #include "initialization/InitAmrCore.H"
 #include "particles/ImpactXParticleContainer.H"
 #include "particles/distribution/Waterbag.H"
@@ -19,6 +20,7 @@
 #include <AMReX_REAL.H>
 #include <AMReX_Utility.H>
 
+#include <cmath>
 #include <limits>
 #include <stdexcept>
 #include <string>
@@ -77,7 +79,7 @@ namespace detail
     }
 }
 
-    void ImpactX::ResizeMesh ()
+    bool ImpactX::ResizeMesh ()
     {
         BL_PROFILE("ImpactX::ResizeMesh");
 
@@ -128,6 +130,31 @@ namespace detail
                 rb[lev].setLo(beam_min - beam_padding);
                 rb[lev].setHi(beam_max + beam_padding);
             }
+
+            // hysteresis: keep the current extent if it is close to the new one
+            //             and still contains the whole beam
+            amrex::Real resize_tolerance = 0.0;
+            pp_geometry.queryAdd("resize_tolerance", resize_tolerance);
+            if (resize_tolerance > 0.0)
+            {
+                amrex::RealBox const current = amr_data->Geom(0).ProbDomain();
+                bool keep = true;
+                for (int dir = 0; dir < AMREX_SPACEDIM; ++dir)
+                {
+                    amrex::Real const tol = resize_tolerance * rb[0].length(dir);
+                    keep = keep && std::abs(current.lo(dir) - rb[0].lo(dir)) <= tol
+                                && std::abs(current.hi(dir) - rb[0].hi(dir)) <= tol
+                                && current.lo(dir) <= beam_min[dir]
+                                && beam_max[dir] <= current.hi(dir);
+                }
+                if (keep)
+                {
+                    for (int lev = 0; lev <= amr_data->finestLevel(); ++lev)
+                    {
+                        rb[lev] = current;
+                    }
+                }
+            }
         }
         else
         {
@@ -144,22 +171,41 @@ namespace detail
                 amrex::Abort("Did not implement ResizeMesh for static domains and >1 MR levels.");
         }
 
-        // updating geometry.prob_lo/hi for consistency
-        amrex::Vector<amrex::Real> const prob_lo = {rb[0].lo()[0], rb[0].lo()[1], rb[0].lo()[2]};
-        amrex::Vector<amrex::Real> const prob_hi = {rb[0].hi()[0], rb[0].hi()[1], rb[0].hi()[2]};
-        pp_geometry.addarr("prob_lo", prob_lo);
-        pp_geometry.addarr("prob_hi", prob_hi);
-
-        // Resize the domain size
-        amrex::Geometry::ResetDefaultProbDomain(rb[0]);
+        bool changed = false;
+        {
+            amrex::RealBox const & current = amr_data->Geom(0).ProbDomain();
+            for (int dir = 0; dir < AMREX_SPACEDIM; ++dir)
+            {
+                changed = changed || current.lo(dir) != rb[0].lo(dir) || current.hi(dir) != rb[0].hi(dir);
+            }
+        }
 
-        for (int lev = 0; lev <= amr_data->finestLevel(); ++lev)
+        if (changed)
         {
-            amrex::Geometry g = amr_data->Geom(lev);
-            g.ProbDomain(rb[lev]);
-            amr_data->SetGeometry(lev, g);
+            // updating geometry.prob_lo/hi for consistency
+            amrex::Vector<amrex::Real> const prob_lo = {rb[0].lo()[0], rb[0].lo()[1], rb[0].lo()[2]};
+            amrex::Vector<amrex::Real> const prob_hi = {rb[0].hi()[0], rb[0].hi()[1], rb[0].hi()[2]};
+            pp_geometry.addarr("prob_lo", prob_lo);
+            pp_geometry.addarr("prob_hi", prob_hi);
 
-            amr_data->m_particle_container->SetParticleGeometry(lev, g);
+            // Resize the domain size
+            amrex::Geometry::ResetDefaultProbDomain(rb[0]);
+
+            for (int lev = 0; lev <= amr_data->finestLevel(); ++lev)
+            {
+                amrex::Geometry g = amr_data->Geom(lev);
+                g.ProbDomain(rb[lev]);
+                amr_data->SetGeometry(lev, g);
+
+                amr_data->m_particle_container->SetParticleGeometry(lev, g);
+            }
+        }
+
+        // boxes and their MPI ranks follow the new beam shape, if requested
+        if (initialization::balanced_decomposition()) {
+            changed = initialization::balance_domain_decomposition(*amr_data) || changed;
         }
+
+        return changed;
     }
 } // namespace impactx
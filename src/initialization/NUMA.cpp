@@ -0,0 +1,99 @@
+/* Copyright 2022-2024 The Regents of the University of California, through Lawrence
+ *           Berkeley National Laboratory (subject to receipt of any required
+ *           approvals from the U.S. Dept. of Energy). All rights reserved.
+ *
+ * This file is part of ImpactX.
+ *
+ * Authors: Axel Huebl
+ * License: BSD-3-Clause-LBNL
+ */
+#include "NUMA.H"
+
+#include <AMReX_OpenMP.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_Print.H>
+
+#if defined(AMREX_USE_OMP)
+#   include <omp.h>
+#endif
+
+#if defined(__linux__)
+#   include <sched.h>
+#   include <sys/mman.h>
+#   include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <numeric>
+#include <set>
+#include <vector>
+
+
+namespace impactx::initialization
+{
+    void
+    report_thread_affinity ()
+    {
+        // CPU of each OpenMP thread of this rank, -1 if unknown
+        int const nthreads = amrex::OpenMP::get_max_threads();
+        std::vector<int> cpus(nthreads, -1);
+#ifdef AMREX_USE_OMP
+#pragma omp parallel
+#endif
+        {
+#if defined(__linux__)
+            cpus[amrex::OpenMP::get_thread_num()] = sched_getcpu();
+#endif
+        }
+
+        bool bound = true;
+#if defined(AMREX_USE_OMP)
+        bound = omp_get_proc_bind() != omp_proc_bind_false;
+#endif
+
+        // gather on the IO rank
+        int const nranks = amrex::ParallelDescriptor::NProcs();
+        int const root = amrex::ParallelDescriptor::IOProcessorNumber();
+        std::vector<int> counts(nranks, 0);
+        amrex::ParallelDescriptor::Gather(&nthreads, 1, counts.data(), 1, root);
+        std::vector<int> displs(nranks, 0);
+        std::partial_sum(counts.begin(), counts.end() - 1, displs.begin() + 1);
+        std::vector<int> all_cpus(displs.back() + counts.back(), -1);
+        amrex::ParallelDescriptor::Gatherv(cpus.data(), nthreads, all_cpus.data(), counts, displs, root);
+
+        amrex::Print() << "\nThread affinity (CPU of each OpenMP thread per MPI rank):\n";
+        bool shared = false;
+        for (int r = 0; r < nranks; ++r) {
+            amrex::Print() << "  rank " << r << ":";
+            std::set<int> unique;
+            for (int t = 0; t < counts[r]; ++t) {
+                int const cpu = all_cpus[displs[r] + t];
+                amrex::Print() << " " << cpu;
+                if (cpu >= 0 && !unique.insert(cpu).second) { shared = true; }
+            }
+            amrex::Print() << "\n";
+        }
+        if (!bound || shared) {
+            amrex::Print() << "  Warning: OpenMP threads are not bound to distinct CPUs, so they can run "
+                           << "far from the memory of their particles. Consider OMP_PROC_BIND=spread "
+                           << "and OMP_PLACES=cores.\n";
+        }
+    }
+
+    void
+    advise_huge_pages ([[maybe_unused]] void * ptr, [[maybe_unused]] std::size_t bytes)
+    {
+#if defined(__linux__) && defined(MADV_HUGEPAGE) && !defined(AMREX_USE_GPU)
+        if (ptr == nullptr || bytes == 0) { return; }
+
+        // madvise needs a page aligned begin
+        auto const page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+        auto const end = reinterpret_cast<std::uintptr_t>(ptr) + bytes;
+        auto const begin = (reinterpret_cast<std::uintptr_t>(ptr) + page - 1) / page * page;
+        if (end <= begin) { return; }
+
+        // only a hint: errors, e.g., with transparent huge pages disabled, are ignored
+        madvise(reinterpret_cast<void *>(begin), end - begin, MADV_HUGEPAGE);
+#endif
+    }
+} // namespace impactx::initialization
@@ -0,0 +1,196 @@
+/* Copyright 2022-2024 The Regents of the University of California, through Lawrence
+ *           Berkeley National Laboratory (subject to receipt of any required
+ *           approvals from the U.S. Dept. of Energy). All rights reserved.
+ *
+ * This file is part of ImpactX.
+ *
+ * Authors: Axel Huebl
+ * License: BSD-3-Clause-LBNL
+ */
+#include "SimplifyLattice.H"
+
+#include <AMReX_BLProfiler.H>
+#include <AMReX_Print.H>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <variant>
+
+
+namespace impactx::initialization
+{
+namespace
+{
+    /** Drift types that can be merged with a drift of the same type */
+    template <typename T>
+    inline constexpr bool is_drift_v =
+        std::is_same_v<T, Drift> || std::is_same_v<T, ChrDrift> || std::is_same_v<T, ExactDrift>;
+
+    /** The name of an element, if it has one */
+    template <typename T_Element>
+    std::optional<std::string>
+    optional_name (T_Element const & element)
+    {
+        if (element.has_name()) { return element.name(); }
+        return std::nullopt;
+    }
+
+    /** Do two elements have the same alignment errors? */
+    bool
+    same_alignment (elements::Alignment const & a, elements::Alignment const & b)
+    {
+        return a.dx() == b.dx() && a.dy() == b.dy() && a.rotation() == b.rotation();
+    }
+
+    /** Does an element leave the beam and the reference particle unchanged?
+     *
+     * @return the element type if it does, otherwise nothing
+     */
+    std::optional<std::string>
+    no_op_type (KnownElements const & element_variant)
+    {
+        return std::visit([](auto const & element) -> std::optional<std::string> {
+            using T = std::decay_t<decltype(element)>;
+            bool no_op = false;
+            if constexpr (std::is_same_v<T, Empty> || std::is_same_v<T, Marker>) {
+                no_op = true;
+            } else if constexpr (is_drift_v<T>) {
+                no_op = element.ds() == 0;
+            } else if constexpr (std::is_same_v<T, Multipole>) {
+                no_op = element.m_Kn == 0 && element.m_Ks == 0;
+            } else if constexpr (std::is_same_v<T, Kicker>) {
+                no_op = element.m_xkick == 0 && element.m_ykick == 0;
+            }
+            if (no_op) { return std::string(T::type); }
+            return std::nullopt;
+        }, element_variant);
+    }
+
+    /** Replace first by the drift first + second, if both are drifts of type T_Drift
+     *
+     * @param keep_slices keep the slice positions, otherwise the merged drift is pushed in one slice
+     */
+    template <typename T_Drift>
+    bool
+    merge_drifts (KnownElements & first, KnownElements const & second, bool keep_slices)
+    {
+        auto const * a = std::get_if<T_Drift>(&first);
+        auto const * b = std::get_if<T_Drift>(&second);
+        if (a == nullptr || b == nullptr) { return false; }
+
+        // keep the positions at which space charge is applied or diagnostics are written
+        int nslice = 1;
+        if (keep_slices) {
+            amrex::ParticleReal const slice_a = a->ds() / a->nslice();
+            amrex::ParticleReal const slice_b = b->ds() / b->nslice();
+            amrex::ParticleReal const tolerance = 1.0e-12 * std::max(std::abs(slice_a), std::abs(slice_b));
+            if (std::abs(slice_a - slice_b) > tolerance) { return false; }
+            nslice = a->nslice() + b->nslice();
+        }
+
+        T_Drift merged(a->ds() + b->ds(), 0, 0, 0, nslice, optional_name(*a));
+        first = std::move(merged);
+        return true;
+    }
+
+    /** Replace first by one multipole with the sum of the coefficients of first and second, if compatible */
+    bool
+    merge_multipoles (KnownElements & first, KnownElements const & second)
+    {
+        auto const * a = std::get_if<Multipole>(&first);
+        auto const * b = std::get_if<Multipole>(&second);
+        if (a == nullptr || b == nullptr) { return false; }
+        if (a->m_multipole != b->m_multipole || !same_alignment(*a, *b)) { return false; }
+
+        Multipole merged(a->m_multipole, a->m_Kn + b->m_Kn, a->m_Ks + b->m_Ks,
+                         a->dx(), a->dy(), a->rotation(), optional_name(*a));
+        first = std::move(merged);
+        return true;
+    }
+
+    /** Replace first by one kicker with the sum of the kicks of first and second, if compatible */
+    bool
+    merge_kickers (KnownElements & first, KnownElements const & second)
+    {
+        auto const * a = std::get_if<Kicker>(&first);
+        auto const * b = std::get_if<Kicker>(&second);
+        if (a == nullptr || b == nullptr) { return false; }
+        if (a->m_unit != b->m_unit || !same_alignment(*a, *b)) { return false; }
+
+        Kicker merged(a->m_xkick + b->m_xkick, a->m_ykick + b->m_ykick, a->m_unit,
+                      a->dx(), a->dy(), a->rotation(), optional_name(*a));
+        first = std::move(merged);
+        return true;
+    }
+} // namespace
+
+    void
+    simplify_lattice (
+        std::list<KnownElements> & lattice,
+        bool collective_effects,
+        bool slice_step_diagnostics,
+        int verbose
+    )
+    {
+        BL_PROFILE("impactx::initialization::simplify_lattice");
+
+        bool const keep_slices = collective_effects || slice_step_diagnostics;
+
+        std::size_t const num_elements = lattice.size();
+        std::map<std::string, int> removed;  // by element type
+        std::map<std::string, int> merged;   // by element type
+
+        // merged kicks can cancel and removed elements can make drifts adjacent: repeat until nothing changes
+        bool changed = true;
+        while (changed) {
+            changed = false;
+
+            for (auto it = lattice.begin(); it != lattice.end(); ) {
+                if (auto const type = no_op_type(*it); type) {
+                    removed[*type]++;
+                    it = lattice.erase(it);
+                    changed = true;
+                } else {
+                    ++it;
+                }
+            }
+
+            for (auto it = lattice.begin(); it != lattice.end(); ) {
+                auto const next = std::next(it);
+                if (next == lattice.end()) { break; }
+
+                std::string const type = std::visit([](auto const & element) { return std::string(element.type); }, *it);
+                bool const merge =
+                    merge_drifts<Drift>(*it, *next, keep_slices) ||
+                    merge_drifts<ChrDrift>(*it, *next, keep_slices) ||
+                    merge_drifts<ExactDrift>(*it, *next, keep_slices) ||
+                    merge_multipoles(*it, *next) ||
+                    merge_kickers(*it, *next);
+                if (merge) {
+                    merged[type]++;
+                    lattice.erase(next);
+                    changed = true;
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        if (verbose > 0) {
+            amrex::Print() << " Lattice simplification: " << num_elements << " -> "
+                           << lattice.size() << " elements\n";
+            for (auto const & [type, count] : removed) {
+                amrex::Print() << "   removed " << count << " " << type << "\n";
+            }
+            for (auto const & [type, count] : merged) {
+                amrex::Print() << "   merged " << count << " " << type << " into its predecessor\n";
+            }
+        }
+    }
+
+} // namespace impactx::initialization
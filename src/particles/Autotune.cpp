@@ -0,0 +1,135 @@
+/* Copyright 2022-2024 The Regents of the University of California, through Lawrence
+ *           Berkeley National Laboratory (subject to receipt of any required
+ *           approvals from the U.S. Dept. of Energy). All rights reserved.
+ *
+ * This file is part of ImpactX.
+ *
+ * Authors: Axel Huebl
+ * License: BSD-3-Clause-LBNL
+ */
+#include "Autotune.H"
+
+#include "initialization/AmrCoreData.H"
+#include "particles/elements/Drift.H"
+
+#include <AMReX_BLProfiler.H>
+#include <AMReX_GpuDevice.H>
+#include <AMReX_OpenMP.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+
+namespace impactx
+{
+namespace
+{
+    /** One candidate configuration of the autotuner */
+    struct Candidate
+    {
+        bool dynamic_scheduling; //! impactx.do_dynamic_scheduling
+        TileThreading threading; //! impactx.tile_threading
+    };
+
+    std::string
+    to_string (TileThreading threading)
+    {
+        switch (threading) {
+            case TileThreading::tiles: return "tiles";
+            case TileThreading::split: return "split";
+            default: return "auto";
+        }
+    }
+
+    /** Inputs of a candidate, one per line if separator is a new line
+     *
+     * The scheduling is only listed for tiles, since split threading does not
+     * use it.
+     */
+    std::string
+    to_string (Candidate const & candidate, std::string const & separator)
+    {
+        std::string inputs;
+        if (candidate.threading == TileThreading::tiles) {
+            inputs += std::string("impactx.do_dynamic_scheduling = ")
+                    + (candidate.dynamic_scheduling ? "true" : "false") + separator;
+        }
+        return inputs + "impactx.tile_threading = " + to_string(candidate.threading);
+    }
+} // namespace
+
+    void
+    autotune (
+        [[maybe_unused]] ImpactXParticleContainer & pc,
+        [[maybe_unused]] initialization::AmrCoreData * amr_core,
+        [[maybe_unused]] int num_pushes
+    )
+    {
+        BL_PROFILE("impactx::autotune");
+
+#if defined(AMREX_USE_OMP) && !defined(AMREX_USE_GPU)
+        if (amrex::OpenMP::get_max_threads() < 2) {
+            amrex::Print() << "Autotune: nothing to tune with one OpenMP thread\n";
+            return;
+        }
+
+        // work on a copy of the beam, so the beam is not pushed
+        ImpactXParticleContainer beam_copy(amr_core);
+        beam_copy.reserveData();
+        beam_copy.resizeData();
+        beam_copy.copyParticles(pc, true);
+        beam_copy.SetRefParticle(pc.GetRefParticle());
+
+        Drift drift(1.0e-6);
+
+        // dynamic scheduling only distributes tiles: one split candidate
+        std::vector<Candidate> const candidates{
+            {true, TileThreading::tiles},
+            {false, TileThreading::tiles},
+            {true, TileThreading::split}
+        };
+
+        amrex::ParmParse pp_impactx("impactx");
+        amrex::Print() << "\nAutotune: seconds per push for " << pc.TotalNumberOfParticles() << " particles\n";
+        int best = 0;
+        amrex::Real best_time = std::numeric_limits<amrex::Real>::max();
+        for (int c = 0; c < static_cast<int>(candidates.size()); ++c) {
+            pp_impactx.add("do_dynamic_scheduling", candidates[c].dynamic_scheduling);
+            beam_copy.SetTileThreading(candidates[c].threading);
+
+            // warm-up, then time
+            drift(beam_copy, 0, 0);
+            amrex::Gpu::streamSynchronize();
+            amrex::Real const start = amrex::ParallelDescriptor::second();
+            for (int n = 0; n < num_pushes; ++n) {
+                drift(beam_copy, 0, 0);
+            }
+            amrex::Gpu::streamSynchronize();
+            amrex::Real time = (amrex::ParallelDescriptor::second() - start) / num_pushes;
+
+            // the slowest rank counts
+            amrex::ParallelDescriptor::ReduceRealMax(time);
+
+            amrex::Print() << "  " << to_string(candidates[c], "  ") << "  : " << time << "\n";
+            if (time < best_time) {
+                best_time = time;
+                best = c;
+            }
+        }
+
+        // use and report the fastest candidate
+        pp_impactx.add("do_dynamic_scheduling", candidates[best].dynamic_scheduling);
+        pp_impactx.add("tile_threading", to_string(candidates[best].threading));
+        pc.SetTileThreading(candidates[best].threading);
+
+        amrex::Print() << "Autotune: fastest configuration, set these inputs to skip autotuning:\n"
+                       << "  " << to_string(candidates[best], "\n  ") << "\n\n";
+#else
+        amrex::Print() << "Autotune: nothing to tune without OpenMP on CPUs\n";
+#endif
+    }
+} // namespace impactx
@@ -30,6 +30,9 @@ namespace impactx
     {
         using namespace amrex::literals; // for _rt and _prt
 
+        // particles are only read
+        PhaseSpaceUpdate const phase_space_update(*this);
+
         // reset the values in rho to zero
         int const nLevel = this->finestLevel();
         for (int lev = 0; lev <= nLevel; ++lev) {
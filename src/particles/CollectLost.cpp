@@ -8,6 +8,7 @@
  * License: BSD-3-Clause-LBNL
  */
 #include "CollectLost.H"
+#include "ParallelForParticles.H"
 
 #include <AMReX_GpuLaunch.H>
 #include <AMReX_GpuQualifiers.H>
@@ -23,6 +24,8 @@ namespace impactx
     {
         int s_index; //!< runtime index of runtime attribute in destination for position s where particle got lost
         amrex::ParticleReal s_lost; //!< position s in meters where particle got lost
+        int period_index; //!< runtime index of runtime attribute in destination for the period where particle got lost
+        amrex::ParticleReal period_lost; //!< period (turn) in which the particle got lost
 
         using SrcData = ImpactXParticleContainer::ParticleTileType::ConstParticleTileDataType;
         using DstData = ImpactXParticleContainer::ParticleTileType::ParticleTileDataType;
@@ -47,17 +50,25 @@ namespace impactx
 
             // remember the current s of the ref particle when lost
             dst.m_runtime_rdata[s_index][dst_ip] = s_lost;
+
+            // remember the period (turn) of periodic lattices when lost
+            dst.m_runtime_rdata[period_index][dst_ip] = period_lost;
         }
     };
 
-    void collect_lost_particles (ImpactXParticleContainer& source)
+    void collect_lost_particles (ImpactXParticleContainer& source, int period)
     {
         BL_PROFILE("impactX::collect_lost_particles");
 
+        // lost particles are only flagged and removed: qm and w stay uniform
+        ImpactXParticleContainer::PhaseSpaceUpdate const phase_space_update(source);
+
         using SrcData = ImpactXParticleContainer::ParticleTileType::ConstParticleTileDataType;
 
         ImpactXParticleContainer& dest = *source.GetLostParticleContainer();
         const int s_runtime_index = dest.GetRealCompIndex("s_lost") - dest.NArrayReal;
+        const int period_runtime_index = dest.GetRealCompIndex("period_lost") - dest.NArrayReal;
+        auto const period_lost = static_cast<amrex::ParticleReal>(period);
 
         RefPart const ref_part = source.GetRefParticle();
         auto const s_lost = ref_part.s;
@@ -66,6 +77,7 @@ namespace impactx
         // been built when constructor was called.
         dest.reserveData();
         dest.resizeData();
+        dest.BumpStateVersion();
 
         // copy all particles marked with a negative ID from source to destination
         int const nLevel = source.finestLevel();
@@ -99,9 +111,9 @@ namespace impactx
                 {
                     auto const src_data = ptile_source.getConstParticleTileData();
 
-                    reduce_op.eval(np, reduce_data, [=] AMREX_GPU_HOST_DEVICE (int ip)
+                    ReduceParticles(reduce_op, reduce_data, np, [=] AMREX_GPU_HOST_DEVICE (long ip)
                     {
-                        return predicate(src_data, ip);
+                        return predicate(src_data, int(ip));
                     });
                 }
                 int const np_to_move = amrex::get<0>(reduce_data.value());
@@ -116,14 +128,14 @@ namespace impactx
                 AMREX_ALWAYS_ASSERT(SrcData::NAI == 0);
                 AMREX_ALWAYS_ASSERT(ptile_source.NumRuntimeIntComps() == 0);
 
-                //   first runtime attribute in destination is s position where particle got lost
-                AMREX_ALWAYS_ASSERT(dest.NumRuntimeRealComps() > 0);
+                //   first runtime attributes in destination are s position and period where particle got lost
+                AMREX_ALWAYS_ASSERT(dest.NumRuntimeRealComps() > 1);
 
                 amrex::filterAndTransformParticles(
                     ptile_dest,
                     ptile_source,
                     predicate,
-                    CopyAndMarkNegative{s_runtime_index, s_lost},
+                    CopyAndMarkNegative{s_runtime_index, s_lost, period_runtime_index, period_lost},
                     0,
                     dst_index
                 );
@@ -10,20 +10,26 @@
 #include "ImpactXParticleContainer.H"
 
 #include "initialization/AmrCoreData.H"
+#include "initialization/NUMA.H"
+#include "particles/ParallelForParticles.H"
 
 #include <ablastr/constant.H>
-#include <ablastr/particles/ParticleMoments.H>
 
 #include <AMReX.H>
 #include <AMReX_AmrCore.H>
 #include <AMReX_AmrParGDB.H>
 #include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParallelReduce.H>
 #include <AMReX_ParmParse.H>
 #include <AMReX_Particle.H>
+#include <AMReX_ParticleReduce.H>
+#include <AMReX_Reduce.H>
 
 #include <algorithm>
+#include <cmath>
 #include <iterator>
 #include <stdexcept>
+#include <string>
 
 
 namespace
@@ -35,17 +41,32 @@ namespace
         pp_impactx.query("do_dynamic_scheduling", do_dynamic);
         return do_dynamic;
     }
+
+    /** Invalidate cached beam statistics when handing out mutable particle data */
+    template<typename T_Container>
+    void mark_modified (T_Container & pc)
+    {
+        if (auto * ipc = dynamic_cast<impactx::ImpactXParticleContainer*>(&pc)) {
+            ipc->MarkModifiedByIterator();
+        }
+    }
 }
 
 namespace impactx
 {
     ParIterSoA::ParIterSoA (ContainerType& pc, int level)
         : amrex::ParIterSoA<RealSoA::nattribs, IntSoA::nattribs>(pc, level,
-                   amrex::MFItInfo().SetDynamic(do_omp_dynamic())) {}
+                   amrex::MFItInfo().SetDynamic(do_omp_dynamic()))
+    {
+        mark_modified(pc);
+    }
 
     ParIterSoA::ParIterSoA (ContainerType& pc, int level, amrex::MFItInfo& info)
         : amrex::ParIterSoA<RealSoA::nattribs, IntSoA::nattribs>(pc, level,
-              info.SetDynamic(do_omp_dynamic())) {}
+              info.SetDynamic(do_omp_dynamic()))
+    {
+        mark_modified(pc);
+    }
 
     ParConstIterSoA::ParConstIterSoA (ContainerType& pc, int level)
         : amrex::ParConstIterSoA<RealSoA::nattribs, IntSoA::nattribs>(pc, level,
@@ -194,11 +215,26 @@ namespace impactx
             }
         }
         auto& particle_tile = DefineAndReturnParticleTile(lid, gid, tid);
+        BumpStateVersion();
+        ResetUniformAttributes();
 
         auto old_np = particle_tile.numParticles();
         auto new_np = old_np + np;
         particle_tile.resize(new_np);
 
+        // optional: back the particle arrays with transparent huge pages, before first touch below
+        bool huge_pages = false;
+        amrex::ParmParse("impactx").queryAdd("particle_huge_pages", huge_pages);
+        if (huge_pages) {
+            auto & soa_all = particle_tile.GetStructOfArrays();
+            for (int comp = 0; comp < soa_all.NumRealComps(); ++comp) {
+                initialization::advise_huge_pages(soa_all.GetRealData(comp).dataPtr() + old_np,
+                                                  np * sizeof(amrex::ParticleReal));
+            }
+            initialization::advise_huge_pages(soa_all.GetIdCPUData().dataPtr() + old_np,
+                                              np * sizeof(uint64_t));
+        }
+
         // Update NextID to include particles created in this function
         int pid;
 #ifdef AMREX_USE_OMP
@@ -233,7 +269,8 @@ namespace impactx
         amrex::ParticleReal const * const AMREX_RESTRICT py_ptr = py.data();
         amrex::ParticleReal const * const AMREX_RESTRICT pt_ptr = pt.data();
 
-        amrex::ParallelFor(np,
+        // first touch of new particle memory: same partitioning across OpenMP threads as in pushes
+        ParallelForParticles(np,
         [=] AMREX_GPU_DEVICE (int i) noexcept
         {
             idcpu_arr[old_np+i] = amrex::SetParticleIDandCPU(pid + i, cpuid);
@@ -285,7 +322,12 @@ namespace impactx
     ImpactXParticleContainer::MinAndMaxPositions ()
     {
         BL_PROFILE("ImpactXParticleContainer::MinAndMaxPositions");
-        return ablastr::particles::MinAndMaxPositions(*this);
+
+        diagnostics::BeamMoments const & moments = GetBeamMoments();
+        return {
+            moments.min[RealSoA::x], moments.min[RealSoA::y], moments.min[RealSoA::z],
+            moments.max[RealSoA::x], moments.max[RealSoA::y], moments.max[RealSoA::z]
+        };
     }
 
     std::tuple<
@@ -295,9 +337,29 @@ namespace impactx
     ImpactXParticleContainer::MeanAndStdPositions ()
     {
         BL_PROFILE("ImpactXParticleContainer::MeanAndStdPositions");
-        return ablastr::particles::MeanAndStdPositions<
-            ImpactXParticleContainer, RealSoA::w
-        >(*this);
+
+        diagnostics::BeamMoments const & moments = GetBeamMoments();
+        return {
+            moments.mean[RealSoA::x], std::sqrt(moments.covariance(RealSoA::x, RealSoA::x)),
+            moments.mean[RealSoA::y], std::sqrt(moments.covariance(RealSoA::y, RealSoA::y)),
+            moments.mean[RealSoA::z], std::sqrt(moments.covariance(RealSoA::z, RealSoA::z))
+        };
+    }
+
+    diagnostics::BeamMoments const &
+    ImpactXParticleContainer::GetBeamMoments () const
+    {
+        // the cache state can differ between ranks, e.g., if only some ranks
+        // iterated their particles mutably: agree before the collective reduction
+        std::uint64_t const version = GetStateVersion();
+        int dirty = (!m_moments.has_value() || m_moments_version != version) ? 1 : 0;
+        amrex::ParallelAllReduce::Max(dirty, amrex::ParallelDescriptor::Communicator());
+        if (dirty == 1)
+        {
+            m_moments = diagnostics::beam_moments(*this);
+            m_moments_version = version;
+        }
+        return *m_moments;
     }
 
     std::vector<std::string>
@@ -323,4 +385,84 @@ namespace impactx
     {
         m_coordsystem = coord_system;
     }
+
+    void
+    ImpactXParticleContainer::SetTrackingDimensions ()
+    {
+        amrex::ParmParse pp_algo("algo");
+        std::string dims = "6d";
+        pp_algo.queryAdd("tracking_dimensions", dims);
+
+        if (dims == "6d") {
+            SetTrackingDimensions(TrackingDimensions::full6d);
+        } else if (dims == "transverse") {
+            SetTrackingDimensions(TrackingDimensions::transverse);
+        } else if (dims == "longitudinal") {
+            SetTrackingDimensions(TrackingDimensions::longitudinal);
+        } else {
+            throw std::runtime_error("algo.tracking_dimensions must be 6d, transverse or longitudinal but is: " + dims);
+        }
+    }
+
+    void
+    ImpactXParticleContainer::SetTileThreading ()
+    {
+        amrex::ParmParse pp_impactx("impactx");
+        std::string threading = "auto";
+        pp_impactx.queryAdd("tile_threading", threading);
+
+        if (threading == "auto") {
+            SetTileThreading(TileThreading::automatic);
+        } else if (threading == "tiles") {
+            SetTileThreading(TileThreading::tiles);
+        } else if (threading == "split") {
+            SetTileThreading(TileThreading::split);
+        } else {
+            throw std::runtime_error("impactx.tile_threading must be auto, tiles or split but is: " + threading);
+        }
+    }
+
+    void
+    ImpactXParticleContainer::UpdateUniformAttributes ()
+    {
+        BL_PROFILE("ImpactXParticleContainer::UpdateUniformAttributes");
+
+        using PType = typename ImpactXParticleContainer::SuperParticleType;
+
+        amrex::ReduceOps<amrex::ReduceOpMin, amrex::ReduceOpMax,
+                         amrex::ReduceOpMin, amrex::ReduceOpMax> reduce_ops;
+        auto r = amrex::ParticleReduce<amrex::ReduceData<
+            amrex::ParticleReal, amrex::ParticleReal,
+            amrex::ParticleReal, amrex::ParticleReal>>(
+            *this,
+            [=] AMREX_GPU_DEVICE (const PType& p) noexcept
+                -> amrex::GpuTuple<amrex::ParticleReal, amrex::ParticleReal,
+                                   amrex::ParticleReal, amrex::ParticleReal>
+            {
+                amrex::ParticleReal const qm = p.rdata(RealSoA::qm);
+                amrex::ParticleReal const w = p.rdata(RealSoA::w);
+                return {qm, qm, w, w};
+            },
+            reduce_ops
+        );
+
+        amrex::ParticleReal min_vals[2] = {amrex::get<0>(r), amrex::get<2>(r)};
+        amrex::ParticleReal max_vals[2] = {amrex::get<1>(r), amrex::get<3>(r)};
+        auto const comm = amrex::ParallelDescriptor::Communicator();
+        amrex::ParallelAllReduce::Min(min_vals, 2, comm);
+        amrex::ParallelAllReduce::Max(max_vals, 2, comm);
+
+        // empty containers keep the initial values of the reduction, min > max
+        ResetUniformAttributes();
+        if (min_vals[0] == max_vals[0]) { m_uniform_qm = min_vals[0]; }
+        if (min_vals[1] == max_vals[1]) { m_uniform_w = min_vals[1]; }
+        m_uniform_stale = false;
+    }
+
+    void
+    ImpactXParticleContainer::ResetUniformAttributes ()
+    {
+        m_uniform_qm.reset();
+        m_uniform_w.reset();
+    }
 } // namespace impactx
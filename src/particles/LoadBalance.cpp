@@ -0,0 +1,213 @@
+/* Copyright 2022-2024 The Regents of the University of California, through Lawrence
+ *           Berkeley National Laboratory (subject to receipt of any required
+ *           approvals from the U.S. Dept. of Energy). All rights reserved.
+ *
+ * This file is part of ImpactX.
+ *
+ * Authors: Axel Huebl
+ * License: BSD-3-Clause-LBNL
+ */
+#include "LoadBalance.H"
+
+#include <AMReX_BLProfiler.H>
+#include <AMReX_GpuContainers.H>
+#include <AMReX_GpuDevice.H>
+#include <AMReX_ParallelDescriptor.H>
+
+#if defined(AMREX_USE_MPI)
+#   include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace impactx
+{
+namespace
+{
+    /** Particles at the end of a tile that are sent to other ranks */
+    struct SendRange
+    {
+        ImpactXParticleContainer::ParticleTileType * tile; //!< the tile
+        int begin; //!< index of the first particle to send
+        int count; //!< number of particles to send
+    };
+} // namespace
+
+    bool
+    rebalance_particles (
+        [[maybe_unused]] ImpactXParticleContainer & pc,
+        [[maybe_unused]] amrex::Real threshold
+    )
+    {
+#if defined(AMREX_USE_MPI)
+        BL_PROFILE("impactx::rebalance_particles");
+
+        int const nranks = amrex::ParallelDescriptor::NProcs();
+        if (nranks == 1) { return false; }
+        int const myrank = amrex::ParallelDescriptor::MyProc();
+        MPI_Comm const comm = amrex::ParallelDescriptor::Communicator();
+
+        // particles per rank and ranks that own a box to add particles to
+        amrex::Long const np_local = pc.TotalNumberOfParticles(true, true);
+        auto const & pmap = pc.ParticleDistributionMap(0).ProcessorMap();
+        auto const my_box = std::find(pmap.begin(), pmap.end(), myrank);
+        int const has_box = my_box != pmap.end() ? 1 : 0;
+
+        std::vector<amrex::Long> counts(nranks);
+        std::vector<int> has_boxes(nranks);
+        amrex::ParallelAllGather::AllGather(&np_local, 1, counts.data(), comm);
+        amrex::ParallelAllGather::AllGather(&has_box, 1, has_boxes.data(), comm);
+
+        amrex::Long const total = std::accumulate(counts.begin(), counts.end(), amrex::Long(0));
+        int const nreceivers = std::accumulate(has_boxes.begin(), has_boxes.end(), 0);
+        if (total == 0 || nreceivers == 0) { return false; }
+
+        amrex::Long const max_count = *std::max_element(counts.begin(), counts.end());
+        amrex::Real const average = amrex::Real(total) / amrex::Real(nreceivers);
+        if (amrex::Real(max_count) <= threshold * average) { return false; }
+
+        // target number of particles per rank: the remainder goes to the first ranks
+        std::vector<amrex::Long> surplus(nranks, 0);
+        std::vector<amrex::Long> deficit(nranks, 0);
+        for (int r = 0, i = 0; r < nranks; ++r) {
+            amrex::Long target = 0;
+            if (has_boxes[r] == 1) {
+                target = total / nreceivers + (i < total % nreceivers ? 1 : 0);
+                ++i;
+            }
+            surplus[r] = std::max(counts[r] - target, amrex::Long(0));
+            deficit[r] = std::max(target - counts[r], amrex::Long(0));
+        }
+
+        // match surplus and deficit ranks in rank order, identical on all ranks
+        std::vector<amrex::Long> send_count(nranks, 0);
+        std::vector<amrex::Long> recv_count(nranks, 0);
+        std::vector<amrex::Long> sent_by(nranks, 0);
+        std::vector<amrex::Long> received_by(nranks, 0);
+        for (int s = 0, d = 0; s < nranks && d < nranks; ) {
+            if (surplus[s] == 0) { ++s; continue; }
+            if (deficit[d] == 0) { ++d; continue; }
+            amrex::Long const n = std::min(surplus[s], deficit[d]);
+            if (s == myrank) { send_count[d] += n; }
+            if (d == myrank) { recv_count[s] += n; }
+            sent_by[s] += n;
+            received_by[d] += n;
+            surplus[s] -= n;
+            deficit[d] -= n;
+        }
+        amrex::Long const nsend = std::accumulate(send_count.begin(), send_count.end(), amrex::Long(0));
+        amrex::Long const nrecv = std::accumulate(recv_count.begin(), recv_count.end(), amrex::Long(0));
+
+        // MPI counts and displacements are int, in units of particles below:
+        // checked on the plan that all ranks share, so all ranks agree
+        amrex::Long const max_moved = std::max(*std::max_element(sent_by.begin(), sent_by.end()),
+                                               *std::max_element(received_by.begin(), received_by.end()));
+        if (max_moved > amrex::Long(std::numeric_limits<int>::max())) {
+            throw std::runtime_error("rebalance_particles: a rank would send or receive " + std::to_string(max_moved) +
+                                     " particles, more than one MPI message can hold. Use more MPI ranks.");
+        }
+
+        // the particles to send are taken from the end of the last tiles
+        std::vector<SendRange> send_ranges;
+        {
+            std::vector<ImpactXParticleContainer::ParticleTileType *> tiles;
+            for (int lev = 0; lev <= pc.finestLevel(); ++lev) {
+                for (auto & [index, ptile] : pc.GetParticles(lev)) {
+                    tiles.push_back(&ptile);
+                }
+            }
+            amrex::Long remaining = nsend;
+            for (auto it = tiles.rbegin(); it != tiles.rend() && remaining > 0; ++it) {
+                int const np = (*it)->numParticles();
+                int const n = static_cast<int>(std::min(remaining, amrex::Long(np)));
+                if (n > 0) { send_ranges.push_back({*it, np - n, n}); }
+                remaining -= n;
+            }
+        }
+
+        // copy the particles to send to the host, one particle after the other
+        int const nreal = pc.NumRealComps();
+        std::vector<amrex::ParticleReal> send_real(nsend * nreal);
+        std::vector<std::uint64_t> send_idcpu(nsend);
+        {
+            amrex::Long offset = 0;
+            std::vector<amrex::ParticleReal> comp_buffer;
+            for (auto const & range : send_ranges) {
+                auto & soa = range.tile->GetStructOfArrays();
+                comp_buffer.resize(range.count);
+                for (int comp = 0; comp < nreal; ++comp) {
+                    amrex::ParticleReal const * const data = soa.GetRealData(comp).dataPtr() + range.begin;
+                    amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, data, data + range.count, comp_buffer.begin());
+                    amrex::Gpu::streamSynchronize();
+                    for (int i = 0; i < range.count; ++i) {
+                        send_real[(offset + i) * nreal + comp] = comp_buffer[i];
+                    }
+                }
+                std::uint64_t const * const idcpu = soa.GetIdCPUData().dataPtr() + range.begin;
+                amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, idcpu, idcpu + range.count,
+                                      send_idcpu.begin() + offset);
+                amrex::Gpu::streamSynchronize();
+
+                range.tile->resize(range.begin);
+                offset += range.count;
+            }
+        }
+
+        // exchange, counting whole particles: nreal values form one element of mpi_particle
+        std::vector<int> send_n(nranks), send_d(nranks), recv_n(nranks), recv_d(nranks);
+        for (int r = 0; r < nranks; ++r) {
+            send_n[r] = static_cast<int>(send_count[r]);
+            recv_n[r] = static_cast<int>(recv_count[r]);
+        }
+        std::exclusive_scan(send_n.begin(), send_n.end(), send_d.begin(), 0);
+        std::exclusive_scan(recv_n.begin(), recv_n.end(), recv_d.begin(), 0);
+
+        std::vector<amrex::ParticleReal> recv_real(nrecv * nreal);
+        std::vector<std::uint64_t> recv_idcpu(nrecv);
+        MPI_Datatype mpi_particle;
+        MPI_Type_contiguous(nreal, amrex::ParallelDescriptor::Mpi_typemap<amrex::ParticleReal>::type(), &mpi_particle);
+        MPI_Type_commit(&mpi_particle);
+        MPI_Alltoallv(send_real.data(), send_n.data(), send_d.data(), mpi_particle,
+                      recv_real.data(), recv_n.data(), recv_d.data(), mpi_particle, comm);
+        MPI_Type_free(&mpi_particle);
+        MPI_Alltoallv(send_idcpu.data(), send_n.data(), send_d.data(), MPI_UINT64_T,
+                      recv_idcpu.data(), recv_n.data(), recv_d.data(), MPI_UINT64_T, comm);
+
+        // append the received particles to the first local box
+        if (nrecv > 0) {
+            int const gid = static_cast<int>(std::distance(pmap.begin(), my_box));
+            auto & ptile = pc.DefineAndReturnParticleTile(0, gid, 0);
+            int const old_np = ptile.numParticles();
+            ptile.resize(old_np + nrecv);
+
+            auto & soa = ptile.GetStructOfArrays();
+            std::vector<amrex::ParticleReal> comp_buffer(nrecv);
+            for (int comp = 0; comp < nreal; ++comp) {
+                for (amrex::Long i = 0; i < nrecv; ++i) {
+                    comp_buffer[i] = recv_real[i * nreal + comp];
+                }
+                amrex::Gpu::copyAsync(amrex::Gpu::hostToDevice, comp_buffer.begin(), comp_buffer.end(),
+                                      soa.GetRealData(comp).dataPtr() + old_np);
+                amrex::Gpu::streamSynchronize();
+            }
+            amrex::Gpu::copyAsync(amrex::Gpu::hostToDevice, recv_idcpu.begin(), recv_idcpu.end(),
+                                  soa.GetIdCPUData().dataPtr() + old_np);
+            amrex::Gpu::streamSynchronize();
+        }
+
+        pc.BumpStateVersion();
+        return true;
+#else
+        return false;
+#endif
+    }
+
+} // namespace impactx
@@ -0,0 +1,81 @@
+/* Copyright 2022-2024 The Regents of the University of California, through Lawrence
+ *           Berkeley National Laboratory (subject to receipt of any required
+ *           approvals from the U.S. Dept. of Energy). All rights reserved.
+ *
+ * This file is part of ImpactX.
+ *
+ * Authors: Axel Huebl
+ * License: BSD-3-Clause-LBNL
+ */
+#include "RefOrbitCache.H"
+
+#include <AMReX_Print.H>
+
+
+namespace impactx::ref_orbit_cache
+{
+namespace
+{
+    bool s_enabled = false;
+    long s_hits = 0;
+    long s_misses = 0;
+} // namespace
+
+namespace detail
+{
+    std::unordered_map<std::string, Entry> &
+    entries ()
+    {
+        static std::unordered_map<std::string, Entry> entries;
+        return entries;
+    }
+
+    void
+    count (bool hit)
+    {
+        if (hit) { ++s_hits; } else { ++s_misses; }
+    }
+} // namespace detail
+
+    void
+    set_enabled (bool enabled)
+    {
+        s_enabled = enabled;
+        if (!enabled) { clear(); }
+    }
+
+    bool
+    enabled ()
+    {
+        return s_enabled;
+    }
+
+    void
+    clear ()
+    {
+        detail::entries().clear();
+        s_hits = 0;
+        s_misses = 0;
+    }
+
+    long
+    hits ()
+    {
+        return s_hits;
+    }
+
+    long
+    misses ()
+    {
+        return s_misses;
+    }
+
+    void
+    report ()
+    {
+        if (s_hits + s_misses == 0) { return; }
+
+        amrex::Print() << " Reference orbit cache: " << s_hits << " hits, " << s_misses << " misses\n";
+    }
+
+} // namespace impactx::ref_orbit_cache
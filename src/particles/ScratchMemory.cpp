@@ -0,0 +1,75 @@
+/* Copyright 2022-2024 The Regents of the University of California, through Lawrence
+ *           Berkeley National Laboratory (subject to receipt of any required
+ *           approvals from the U.S. Dept. of Energy). All rights reserved.
+ *
+ * This file is part of ImpactX.
+ *
+ * Authors: Axel Huebl
+ * License: BSD-3-Clause-LBNL
+ */
+#include "ScratchMemory.H"
+
+#include <AMReX.H>
+#include <AMReX_Print.H>
+
+#include <set>
+
+
+namespace impactx::scratch
+{
+namespace
+{
+    std::set<PoolBase *> & pools ()
+    {
+        static std::set<PoolBase *> all_pools;
+        return all_pools;
+    }
+
+    //! release_all is registered with the current AMReX session
+    bool release_on_finalize = false;
+} // namespace
+
+    void
+    register_pool (PoolBase * pool)
+    {
+        pools().insert(pool);
+        if (!release_on_finalize) {
+            amrex::ExecOnFinalize(release_all);
+            release_on_finalize = true;
+        }
+    }
+
+    void
+    release_all ()
+    {
+        for (PoolBase * pool : pools()) {
+            pool->clear();
+            pool->m_bytes_high_water = pool->m_bytes_held;
+            pool->m_num_allocations = 0;
+        }
+        release_on_finalize = false;
+    }
+
+    void
+    report ()
+    {
+        std::size_t high_water = 0;
+        int num_allocations = 0;
+        for (PoolBase const * pool : pools()) {
+            high_water += pool->m_bytes_high_water;
+            num_allocations += pool->m_num_allocations;
+        }
+        if (num_allocations == 0) { return; }
+
+        amrex::Print() << "Scratch memory high-water: " << double(high_water) / (1024.0 * 1024.0)
+                       << " MiB in " << num_allocations << " buffers\n";
+    }
+
+    std::size_t
+    size_class (std::size_t n)
+    {
+        std::size_t capacity = 64;
+        while (capacity < n) { capacity *= 2; }
+        return capacity;
+    }
+} // namespace impactx::scratch
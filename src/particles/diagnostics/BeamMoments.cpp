@@ -0,0 +1,242 @@
+/* Copyright 2022-2024 The Regents of the University of California, through Lawrence
+ *           Berkeley National Laboratory (subject to receipt of any required
+ *           approvals from the U.S. Dept. of Energy). All rights reserved.
+ *
+ * This file is part of ImpactX.
+ *
+ * Authors: Axel Huebl, Chad Mitchell
+ * License: BSD-3-Clause-LBNL
+ */
+#include "BeamMoments.H"
+
+#include "particles/ImpactXParticleContainer.H"
+#include "particles/ParallelForParticles.H"
+
+#include <AMReX_BLProfiler.H>           // for TinyProfiler
+#include <AMReX_GpuContainers.H>        // for Gpu::copyAsync
+#include <AMReX_GpuQualifiers.H>        // for AMREX_GPU_DEVICE
+#include <AMReX_ParallelDescriptor.H>   // for ParallelDescriptor
+#include <AMReX_REAL.H>                 // for ParticleReal
+#include <AMReX_Reduce.H>               // for ReduceOps
+#include <AMReX_TypeList.H>             // for TypeMultiplier
+
+#if defined(AMREX_USE_MPI)
+#   include <mpi.h>
+#endif
+
+#include <array>
+#include <optional>
+
+
+namespace impactx::diagnostics
+{
+namespace
+{
+    /** Phase space coordinates of one particle of this rank
+     *
+     * Used as the shift for the accumulation of deviations. Any particle
+     * of the beam is close to the mean compared to a large beam offset.
+     */
+    std::array<amrex::ParticleReal, BeamMoments::ndim>
+    local_shift (ImpactXParticleContainer const & pc)
+    {
+        std::array<amrex::ParticleReal, BeamMoments::ndim> shift{};
+
+        int const nLevel = pc.finestLevel();
+        for (int lev = 0; lev <= nLevel; ++lev) {
+            for (auto const & [index, ptile] : pc.GetParticles(lev)) {
+                if (ptile.numParticles() == 0) { continue; }
+
+                auto const & soa = ptile.GetStructOfArrays();
+                for (int d = 0; d < BeamMoments::ndim; ++d) {
+                    amrex::ParticleReal const * const part = soa.GetRealData(d).dataPtr();
+                    amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, part, part + 1, &shift[d]);
+                }
+                amrex::Gpu::streamSynchronize();
+                return shift;
+            }
+        }
+        return shift;
+    }
+
+#if defined(AMREX_USE_MPI)
+    /** MPI reduction operator: merge BeamMoments records pairwise
+     *
+     * @see MPI_User_function
+     */
+    void
+    merge_moments (void * invec, void * inoutvec, int * len, MPI_Datatype * /* datatype */)
+    {
+        auto const * in = static_cast<amrex::ParticleReal const *>(invec);
+        auto * inout = static_cast<amrex::ParticleReal *>(inoutvec);
+
+        for (int i = 0; i < *len; ++i) {
+            BeamMoments a, b;
+            a.unpack(in + i * BeamMoments::nvalues);
+            b.unpack(inout + i * BeamMoments::nvalues);
+            a.merge(b);
+            a.pack(inout + i * BeamMoments::nvalues);
+        }
+    }
+#endif
+} // namespace
+
+    BeamMoments
+    local_beam_moments (ImpactXParticleContainer const & pc)
+    {
+        BL_PROFILE("impactx::diagnostics::local_beam_moments");
+
+        static constexpr int ndim = BeamMoments::ndim;
+
+        auto const shift_arr = local_shift(pc);
+        amrex::GpuArray<amrex::ParticleReal, ndim> shift;
+        for (int d = 0; d < ndim; ++d) { shift[d] = shift_arr[d]; }
+
+        // skip loading the particle weights if they are all equal
+        std::optional<amrex::ParticleReal> const uniform_w = pc.GetUniformWeight();
+        bool const load_w = !uniform_w.has_value();
+        amrex::ParticleReal const w_value = uniform_w.value_or(0.0);
+
+        /* The variables below need to be static to work around an MSVC bug
+         * https://stackoverflow.com/questions/55136414/constexpr-variable-captured-inside-lambda-loses-its-constexpr-ness
+         */
+        // numbers of same type reduction operations
+        static constexpr std::size_t num_red_ops_sum = 1 + ndim + BeamMoments::ncomoments;  // w, first and second moments
+        static constexpr std::size_t num_red_ops_min = ndim;  // minimum
+        static constexpr std::size_t num_red_ops_max = ndim;  // maximum
+
+        // prepare reduction operations for shifted sums and min/max values in 6D phase space
+        amrex::TypeMultiplier<amrex::ReduceOps,
+            amrex::ReduceOpSum[num_red_ops_sum],
+            amrex::ReduceOpMin[num_red_ops_min],
+            amrex::ReduceOpMax[num_red_ops_max]
+        > reduce_ops;
+        using ReducedDataT = amrex::TypeMultiplier<amrex::ReduceData, amrex::ParticleReal[num_red_ops_sum + num_red_ops_min + num_red_ops_max]>;
+        ReducedDataT reduce_data(reduce_ops);
+
+        int const nLevel = pc.finestLevel();
+        for (int lev = 0; lev <= nLevel; ++lev) {
+            // with fewer tiles than threads, the tiles are split instead
+            [[maybe_unused]] bool const thread_tiles = thread_over_tiles(pc, lev);
+#ifdef AMREX_USE_OMP
+#pragma omp parallel if (amrex::Gpu::notInLaunchRegion() && thread_tiles)
+#endif
+            for (ParConstIterSoA pti(pc, lev); pti.isValid(); ++pti) {
+                // preparing access to particle data: SoA
+                auto const & soa = pti.GetStructOfArrays();
+                amrex::GpuArray<amrex::ParticleReal const *, ndim> part;
+                for (int d = 0; d < ndim; ++d) { part[d] = soa.GetRealData(d).dataPtr(); }
+                amrex::ParticleReal const * const AMREX_RESTRICT part_w =
+                    load_w ? soa.GetRealData(RealSoA::w).dataPtr() : nullptr;
+
+                ReduceParticles(reduce_ops, reduce_data, pti.numParticles(),
+                    [=] AMREX_GPU_DEVICE (long ip) noexcept -> ReducedDataT::Type
+                    {
+                        amrex::ParticleReal const p_w = part_w != nullptr ? part_w[ip] : w_value;
+
+                        // phase space coordinates and their deviation from the shift
+                        amrex::ParticleReal v[ndim];
+                        amrex::ParticleReal d[ndim];
+                        for (int i = 0; i < ndim; ++i) {
+                            v[i] = part[i][ip];
+                            d[i] = v[i] - shift[i];
+                        }
+
+                        ReducedDataT::Type out;
+                        amrex::get<0>(out) = p_w;
+                        amrex::constexpr_for<0, ndim>([&](auto i) {
+                            constexpr int ci = decltype(i)::value;
+                            amrex::get<1 + ci>(out) = p_w * d[ci];
+                            amrex::get<num_red_ops_sum + ci>(out) = v[ci];
+                            amrex::get<num_red_ops_sum + ndim + ci>(out) = v[ci];
+                            amrex::constexpr_for<ci, ndim>([&](auto j) {
+                                constexpr int cj = decltype(j)::value;
+                                amrex::get<1 + ndim + BeamMoments::index(ci, cj)>(out) = p_w * d[ci] * d[cj];
+                            });
+                        });
+                        return out;
+                    }
+                );
+            }
+        }
+        auto const r = reduce_data.value(reduce_ops);
+
+        // shifted sums to mean and co-moments
+        BeamMoments m;
+        m.w_sum = amrex::get<0>(r);
+
+        std::array<amrex::ParticleReal, ndim> s1{};
+        amrex::constexpr_for<0, ndim>([&](auto i) {
+            constexpr int ci = decltype(i)::value;
+            s1[ci] = amrex::get<1 + ci>(r);
+            m.min[ci] = amrex::get<num_red_ops_sum + ci>(r);
+            m.max[ci] = amrex::get<num_red_ops_sum + ndim + ci>(r);
+            amrex::constexpr_for<ci, ndim>([&](auto j) {
+                constexpr int cj = decltype(j)::value;
+                m.comoment[BeamMoments::index(ci, cj)] = amrex::get<1 + ndim + BeamMoments::index(ci, cj)>(r);
+            });
+        });
+
+        if (m.w_sum > 0.0) {
+            for (int i = 0; i < ndim; ++i) {
+                m.mean[i] = shift[i] + s1[i] / m.w_sum;
+            }
+            for (int i = 0; i < ndim; ++i) {
+                for (int j = i; j < ndim; ++j) {
+                    m.comoment[BeamMoments::index(i, j)] -= s1[i] * s1[j] / m.w_sum;
+                }
+            }
+        } else {
+            m.comoment.fill(0.0);
+        }
+
+        return m;
+    }
+
+    void
+    AllReduce ([[maybe_unused]] std::vector<BeamMoments> & moments)
+    {
+#if defined(AMREX_USE_MPI)
+        BL_PROFILE("impactx::diagnostics::AllReduce(BeamMoments)");
+
+        if (amrex::ParallelDescriptor::NProcs() == 1 || moments.empty()) { return; }
+
+        std::vector<amrex::ParticleReal> buffer(moments.size() * BeamMoments::nvalues);
+        for (std::size_t i = 0; i < moments.size(); ++i) {
+            moments[i].pack(buffer.data() + i * BeamMoments::nvalues);
+        }
+
+        // one record is one BeamMoments entry
+        MPI_Datatype record_type;
+        MPI_Type_contiguous(BeamMoments::nvalues,
+                            amrex::ParallelDescriptor::Mpi_typemap<amrex::ParticleReal>::type(),
+                            &record_type);
+        MPI_Type_commit(&record_type);
+
+        // not declared commutative: keeps the merge order and thus the result reproducible
+        MPI_Op merge_op;
+        MPI_Op_create(&merge_moments, 0, &merge_op);
+
+        MPI_Allreduce(MPI_IN_PLACE, buffer.data(), static_cast<int>(moments.size()),
+                      record_type, merge_op, amrex::ParallelDescriptor::Communicator());
+
+        MPI_Op_free(&merge_op);
+        MPI_Type_free(&record_type);
+
+        for (std::size_t i = 0; i < moments.size(); ++i) {
+            moments[i].unpack(buffer.data() + i * BeamMoments::nvalues);
+        }
+#endif
+    }
+
+    BeamMoments
+    beam_moments (ImpactXParticleContainer const & pc)
+    {
+        BL_PROFILE("impactx::diagnostics::beam_moments");
+
+        std::vector<BeamMoments> moments{local_beam_moments(pc)};
+        AllReduce(moments);
+        return moments[0];
+    }
+
+} // namespace impactx::diagnostics
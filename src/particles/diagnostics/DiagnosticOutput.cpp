@@ -8,6 +8,7 @@
  * License: BSD-3-Clause-LBNL
  */
 #include "DiagnosticOutput.H"
+#include "BeamMoments.H"
 #include "NonlinearLensInvariants.H"
 #include "ReducedBeamCharacteristics.H"
 
@@ -17,11 +18,118 @@
 #include <AMReX_REAL.H>       // for ParticleReal
 #include <AMReX_Print.H>      // for PrintToFile
 #include <AMReX_ParticleTile.H>     // for constructor of SoAParticle
+#include <AMReX_GpuContainers.H>    // for Gpu::DeviceVector
 
+#include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <utility>
+#include <vector>
 
 
+namespace
+{
+    /** Write the column names of the reduced beam characteristics file
+     *
+     * @param file_handler the file to write to
+     * @param eigenemittances add columns for eigenemittances
+     */
+    void
+    write_reduced_beam_characteristics_header (amrex::AllPrintToFile & file_handler,
+                                               bool eigenemittances)
+    {
+        if (eigenemittances) {
+           file_handler << "step" << " " << "s" << " "
+                     << "x_mean" << " " << "x_min" << " " << "x_max" << " "
+                     << "y_mean" << " " << "y_min" << " " << "y_max" << " "
+                     << "t_mean" << " " << "t_min" << " " << "t_max" << " "
+                     << "sig_x" << " " << "sig_y" << " " << "sig_t" << " "
+                     << "px_mean" << " " << "px_min" << " " << "px_max" << " "
+                     << "py_mean" << " " << "py_min" << " " << "py_max" << " "
+                     << "pt_mean" << " " << "pt_min" << " " << "pt_max" << " "
+                     << "sig_px" << " " << "sig_py" << " " << "sig_pt" << " "
+                     << "emittance_x" << " " << "emittance_y" << " " << "emittance_t" << " "
+                     << "alpha_x" << " " << "alpha_y" << " " << "alpha_t" << " "
+                     << "beta_x" << " " << "beta_y" << " " << "beta_t" << " "
+                     << "dispersion_x" << " " << "dispersion_px" << " "
+                     << "dispersion_y" << " " << "dispersion_py" << " "
+                     << "emittance_xn" << " " << "emittance_yn" << " " << "emittance_tn" << " "
+                     << "emittance_1" << " " << "emittance_2" << " " << "emittance_3" << " "
+                     << "charge_C" << " "
+                     << "\n";
+        } else {
+           file_handler << "step" << " " << "s" << " "
+                     << "x_mean" << " " << "x_min" << " " << "x_max" << " "
+                     << "y_mean" << " " << "y_min" << " " << "y_max" << " "
+                     << "t_mean" << " " << "t_min" << " " << "t_max" << " "
+                     << "sig_x" << " " << "sig_y" << " " << "sig_t" << " "
+                     << "px_mean" << " " << "px_min" << " " << "px_max" << " "
+                     << "py_mean" << " " << "py_min" << " " << "py_max" << " "
+                     << "pt_mean" << " " << "pt_min" << " " << "pt_max" << " "
+                     << "sig_px" << " " << "sig_py" << " " << "sig_pt" << " "
+                     << "emittance_x" << " " << "emittance_y" << " " << "emittance_t" << " "
+                     << "alpha_x" << " " << "alpha_y" << " " << "alpha_t" << " "
+                     << "beta_x" << " " << "beta_y" << " " << "beta_t" << " "
+                     << "dispersion_x" << " " << "dispersion_px" << " "
+                     << "dispersion_y" << " " << "dispersion_py" << " "
+                     << "emittance_xn" << " " << "emittance_yn" << " " << "emittance_tn" << " "
+                     << "charge_C" << " "
+                     << "\n";
+        }
+    }
+
+    /** Write one line of the reduced beam characteristics file
+     *
+     * @param file_handler the file to write to
+     * @param step the global step
+     * @param s the position of the reference particle
+     * @param rbc the reduced beam characteristics
+     */
+    void
+    write_reduced_beam_characteristics (amrex::AllPrintToFile & file_handler,
+                                        int step,
+                                        amrex::ParticleReal s,
+                                        impactx::diagnostics::ReducedBeamCharacteristics const & rbc)
+    {
+        if (rbc.has_eigenemittances) {
+           file_handler << step << " " << s << " "
+                     << rbc.x_mean << " " << rbc.x_min << " " << rbc.x_max << " "
+                     << rbc.y_mean << " " << rbc.y_min << " " << rbc.y_max << " "
+                     << rbc.t_mean << " " << rbc.t_min << " " << rbc.t_max << " "
+                     << rbc.sig_x << " " << rbc.sig_y << " " << rbc.sig_t << " "
+                     << rbc.px_mean << " " << rbc.px_min << " " << rbc.px_max << " "
+                     << rbc.py_mean << " " << rbc.py_min << " " << rbc.py_max << " "
+                     << rbc.pt_mean << " " << rbc.pt_min << " " << rbc.pt_max << " "
+                     << rbc.sig_px << " " << rbc.sig_py << " " << rbc.sig_pt << " "
+                     << rbc.emittance_x << " " << rbc.emittance_y << " " << rbc.emittance_t << " "
+                     << rbc.alpha_x << " " << rbc.alpha_y << " " << rbc.alpha_t << " "
+                     << rbc.beta_x << " " << rbc.beta_y << " " << rbc.beta_t << " "
+                     << rbc.dispersion_x << " " << rbc.dispersion_px << " "
+                     << rbc.dispersion_y << " " << rbc.dispersion_py << " "
+                     << rbc.emittance_xn << " " << rbc.emittance_yn << " " << rbc.emittance_tn << " "
+                     << rbc.emittance_1 << " " << rbc.emittance_2 << " " << rbc.emittance_3 << " "
+                     << rbc.charge_C << "\n";
+        } else {
+           file_handler << step << " " << s << " "
+                     << rbc.x_mean << " " << rbc.x_min << " " << rbc.x_max << " "
+                     << rbc.y_mean << " " << rbc.y_min << " " << rbc.y_max << " "
+                     << rbc.t_mean << " " << rbc.t_min << " " << rbc.t_max << " "
+                     << rbc.sig_x << " " << rbc.sig_y << " " << rbc.sig_t << " "
+                     << rbc.px_mean << " " << rbc.px_min << " " << rbc.px_max << " "
+                     << rbc.py_mean << " " << rbc.py_min << " " << rbc.py_max << " "
+                     << rbc.pt_mean << " " << rbc.pt_min << " " << rbc.pt_max << " "
+                     << rbc.sig_px << " " << rbc.sig_py << " " << rbc.sig_pt << " "
+                     << rbc.emittance_x << " " << rbc.emittance_y << " " << rbc.emittance_t << " "
+                     << rbc.alpha_x << " " << rbc.alpha_y << " " << rbc.alpha_t << " "
+                     << rbc.beta_x << " " << rbc.beta_y << " " << rbc.beta_t << " "
+                     << rbc.dispersion_x << " " << rbc.dispersion_px << " "
+                     << rbc.dispersion_y << " " << rbc.dispersion_py << " "
+                     << rbc.emittance_xn << " " << rbc.emittance_yn << " " << rbc.emittance_tn << " "
+                     << rbc.charge_C << "\n";
+        }
+    }
+} // namespace
+
 namespace impactx::diagnostics
 {
     void DiagnosticOutput (ImpactXParticleContainer const & pc,
@@ -49,44 +157,7 @@ namespace impactx::diagnostics
                 bool compute_eigenemittances = false;
                 pp_diag.queryAdd("eigenemittances", compute_eigenemittances);
 
-                if (compute_eigenemittances) {
-                   file_handler << "step" << " " << "s" << " "
-                             << "x_mean" << " " << "x_min" << " " << "x_max" << " "
-                             << "y_mean" << " " << "y_min" << " " << "y_max" << " "
-                             << "t_mean" << " " << "t_min" << " " << "t_max" << " "
-                             << "sig_x" << " " << "sig_y" << " " << "sig_t" << " "
-                             << "px_mean" << " " << "px_min" << " " << "px_max" << " "
-                             << "py_mean" << " " << "py_min" << " " << "py_max" << " "
-                             << "pt_mean" << " " << "pt_min" << " " << "pt_max" << " "
-                             << "sig_px" << " " << "sig_py" << " " << "sig_pt" << " "
-                             << "emittance_x" << " " << "emittance_y" << " " << "emittance_t" << " "
-                             << "alpha_x" << " " << "alpha_y" << " " << "alpha_t" << " "
-                             << "beta_x" << " " << "beta_y" << " " << "beta_t" << " "
-                             << "dispersion_x" << " " << "dispersion_px" << " "
-                             << "dispersion_y" << " " << "dispersion_py" << " "
-                             << "emittance_xn" << " " << "emittance_yn" << " " << "emittance_tn" << " "
-                             << "emittance_1" << " " << "emittance_2" << " " << "emittance_3" << " "
-                             << "charge_C" << " "
-                             << "\n";
-                } else {
-                   file_handler << "step" << " " << "s" << " "
-                             << "x_mean" << " " << "x_min" << " " << "x_max" << " "
-                             << "y_mean" << " " << "y_min" << " " << "y_max" << " "
-                             << "t_mean" << " " << "t_min" << " " << "t_max" << " "
-                             << "sig_x" << " " << "sig_y" << " " << "sig_t" << " "
-                             << "px_mean" << " " << "px_min" << " " << "px_max" << " "
-                             << "py_mean" << " " << "py_min" << " " << "py_max" << " "
-                             << "pt_mean" << " " << "pt_min" << " " << "pt_max" << " "
-                             << "sig_px" << " " << "sig_py" << " " << "sig_pt" << " "
-                             << "emittance_x" << " " << "emittance_y" << " " << "emittance_t" << " "
-                             << "alpha_x" << " " << "alpha_y" << " " << "alpha_t" << " "
-                             << "beta_x" << " " << "beta_y" << " " << "beta_t" << " "
-                             << "dispersion_x" << " " << "dispersion_px" << " "
-                             << "dispersion_y" << " " << "dispersion_py" << " "
-                             << "emittance_xn" << " " << "emittance_yn" << " " << "emittance_tn" << " "
-                             << "charge_C" << " "
-                             << "\n";
-                }
+                write_reduced_beam_characteristics_header(file_handler, compute_eigenemittances);
             }
         }
 
@@ -115,120 +186,129 @@ namespace impactx::diagnostics
                     << px << " " << py << " " << pz << " " << pt << "\n";
         } // if( otype == OutputType::PrintRefParticle)
         else if (otype == OutputType::PrintReducedBeamCharacteristics) {
-            std::unordered_map<std::string, amrex::ParticleReal> const rbc =
+            ReducedBeamCharacteristics const rbc =
                 diagnostics::reduced_beam_characteristics(pc);
 
             amrex::ParticleReal const s = pc.GetRefParticle().s;
 
-            // determine whether to output eigenemittances
-            amrex::ParmParse pp_diag("diag");
-            bool compute_eigenemittances = false;
-            pp_diag.queryAdd("eigenemittances", compute_eigenemittances);
-
-            if (compute_eigenemittances) {
-               file_handler << step << " " << s << " "
-                         << rbc.at("x_mean") << " " << rbc.at("x_min") << " " << rbc.at("x_max") << " "
-                         << rbc.at("y_mean") << " " << rbc.at("y_min") << " " << rbc.at("y_max") << " "
-                         << rbc.at("t_mean") << " " << rbc.at("t_min") << " " << rbc.at("t_max") << " "
-                         << rbc.at("sig_x") << " " << rbc.at("sig_y") << " " << rbc.at("sig_t") << " "
-                         << rbc.at("px_mean") << " " << rbc.at("px_min") << " " << rbc.at("px_max") << " "
-                         << rbc.at("py_mean") << " " << rbc.at("py_min") << " " << rbc.at("py_max") << " "
-                         << rbc.at("pt_mean") << " " << rbc.at("pt_min") << " " << rbc.at("pt_max") << " "
-                         << rbc.at("sig_px") << " " << rbc.at("sig_py") << " " << rbc.at("sig_pt") << " "
-                         << rbc.at("emittance_x") << " " << rbc.at("emittance_y") << " " << rbc.at("emittance_t") << " "
-                         << rbc.at("alpha_x") << " " << rbc.at("alpha_y") << " " << rbc.at("alpha_t") << " "
-                         << rbc.at("beta_x") << " " << rbc.at("beta_y") << " " << rbc.at("beta_t") << " "
-                         << rbc.at("dispersion_x") << " " << rbc.at("dispersion_px") << " "
-                         << rbc.at("dispersion_y") << " " << rbc.at("dispersion_py") << " "
-                         << rbc.at("emittance_xn") << " " << rbc.at("emittance_yn") << " " << rbc.at("emittance_tn") << " "
-                         << rbc.at("emittance_1") << " " << rbc.at("emittance_2") << " " << rbc.at("emittance_3") << " "
-                         << rbc.at("charge_C") << "\n";
-            } else {
-               file_handler << step << " " << s << " "
-                         << rbc.at("x_mean") << " " << rbc.at("x_min") << " " << rbc.at("x_max") << " "
-                         << rbc.at("y_mean") << " " << rbc.at("y_min") << " " << rbc.at("y_max") << " "
-                         << rbc.at("t_mean") << " " << rbc.at("t_min") << " " << rbc.at("t_max") << " "
-                         << rbc.at("sig_x") << " " << rbc.at("sig_y") << " " << rbc.at("sig_t") << " "
-                         << rbc.at("px_mean") << " " << rbc.at("px_min") << " " << rbc.at("px_max") << " "
-                         << rbc.at("py_mean") << " " << rbc.at("py_min") << " " << rbc.at("py_max") << " "
-                         << rbc.at("pt_mean") << " " << rbc.at("pt_min") << " " << rbc.at("pt_max") << " "
-                         << rbc.at("sig_px") << " " << rbc.at("sig_py") << " " << rbc.at("sig_pt") << " "
-                         << rbc.at("emittance_x") << " " << rbc.at("emittance_y") << " " << rbc.at("emittance_t") << " "
-                         << rbc.at("alpha_x") << " " << rbc.at("alpha_y") << " " << rbc.at("alpha_t") << " "
-                         << rbc.at("beta_x") << " " << rbc.at("beta_y") << " " << rbc.at("beta_t") << " "
-                         << rbc.at("dispersion_x") << " " << rbc.at("dispersion_px") << " "
-                         << rbc.at("dispersion_y") << " " << rbc.at("dispersion_py") << " "
-                         << rbc.at("emittance_xn") << " " << rbc.at("emittance_yn") << " " << rbc.at("emittance_tn") << " "
-                         << rbc.at("charge_C") << "\n";
-            }
+            write_reduced_beam_characteristics(file_handler, step, s, rbc);
         } // if( otype == OutputType::PrintReducedBeamCharacteristics)
 
-        // TODO: add as an option to the monitor element
+        // note: the BeamMonitor element writes these invariants as binary
+        //       openPMD records and histograms (nonlinear_lens_invariants)
         if (otype == OutputType::PrintNonlinearLensInvariants) {
-            // create a host-side particle buffer
-            auto tmp = pc.make_alike<amrex::PinnedArenaAllocator>();
+            // parse the diagnostic parameters once
+            NonlinearLensInvariants const nonlinear_lens_invariants =
+                nonlinear_lens_invariants_from_inputs("diag");
 
-            // copy all particles from device to host
-            bool const local = true;
-            tmp.copyParticles(pc, local);
+            // host-side buffers for one tile
+            std::vector<uint64_t> h_idcpu;
+            std::vector<amrex::ParticleReal> h_H, h_I;
 
             // loop over refinement levels
-            int const nLevel = tmp.finestLevel();
+            int const nLevel = pc.finestLevel();
             for (int lev = 0; lev <= nLevel; ++lev) {
                 // loop over all particle boxes
-                using MyPinnedParIter = amrex::ParIterSoA<RealSoA::nattribs,IntSoA::nattribs, amrex::PinnedArenaAllocator>;
-                for (MyPinnedParIter pti(tmp, lev); pti.isValid(); ++pti) {
+                for (ParConstIterSoA pti(pc, lev); pti.isValid(); ++pti) {
                     const int np = pti.numParticles();
 
                     // preparing access to particle data: SoA of Reals
                     auto const& soa = pti.GetStructOfArrays();
-                    auto const& part_x = soa.GetRealData(RealSoA::x);
-                    auto const& part_y = soa.GetRealData(RealSoA::y);
-                    auto const& part_px = soa.GetRealData(RealSoA::px);
-                    auto const& part_py = soa.GetRealData(RealSoA::py);
-
-                    auto const& part_idcpu = soa.GetIdCPUData().dataPtr();
+                    amrex::ParticleReal const * const AMREX_RESTRICT part_x = soa.GetRealData(RealSoA::x).dataPtr();
+                    amrex::ParticleReal const * const AMREX_RESTRICT part_y = soa.GetRealData(RealSoA::y).dataPtr();
+                    amrex::ParticleReal const * const AMREX_RESTRICT part_px = soa.GetRealData(RealSoA::px).dataPtr();
+                    amrex::ParticleReal const * const AMREX_RESTRICT part_py = soa.GetRealData(RealSoA::py).dataPtr();
+                    uint64_t const * const AMREX_RESTRICT part_idcpu = soa.GetIdCPUData().dataPtr();
+
+                    // calculate invariants of motion in parallel
+                    amrex::Gpu::DeviceVector<amrex::ParticleReal> d_H(np), d_I(np);
+                    amrex::ParticleReal * const AMREX_RESTRICT part_H = d_H.dataPtr();
+                    amrex::ParticleReal * const AMREX_RESTRICT part_I = d_I.dataPtr();
+                    amrex::ParallelFor(np, [=] AMREX_GPU_DEVICE (int i) {
+                        NonlinearLensInvariants::Data const HI_out =
+                                nonlinear_lens_invariants(part_x[i], part_y[i], part_px[i], part_py[i]);
+                        part_H[i] = HI_out.H;
+                        part_I[i] = HI_out.I;
+                    });
+
+                    // copy only ids and invariants to the host
+                    h_idcpu.resize(np);
+                    h_H.resize(np);
+                    h_I.resize(np);
+                    amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, part_idcpu, part_idcpu + np, h_idcpu.begin());
+                    amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, d_H.begin(), d_H.end(), h_H.begin());
+                    amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, d_I.begin(), d_I.end(), h_I.begin());
+                    amrex::Gpu::streamSynchronize();
+
+                    // write particle invariant data to file
+                    for (int i = 0; i < np; ++i) {
+                        file_handler
+                                << h_idcpu[i] << " "
+                                << h_H[i] << " " << h_I[i] << "\n";
+                    }
+                } // end loop over all particle boxes
+            } // end mesh-refinement level loop
+        }
+    }
 
-                    // Parse the diagnostic parameters
-                    amrex::ParmParse pp_diag("diag");
+    BatchedReducedBeamCharacteristics::BatchedReducedBeamCharacteristics (
+        std::string file_name,
+        int flush_interval,
+        bool append
+    )
+    : m_file_name(std::move(file_name)),
+      m_flush_interval(std::max(flush_interval, 1))
+    {
+        // determine whether to output eigenemittances
+        amrex::ParmParse pp_diag("diag");
+        pp_diag.queryAdd("eigenemittances", m_compute_eigenemittances);
 
-                    amrex::ParticleReal alpha = 0.0;
-                    pp_diag.queryAdd("alpha", alpha);
+        if (!append) {
+            amrex::AllPrintToFile file_handler(m_file_name);
+            write_reduced_beam_characteristics_header(file_handler, m_compute_eigenemittances);
+        }
 
-                    amrex::ParticleReal beta = 1.0;
-                    pp_diag.queryAdd("beta", beta);
+        m_steps.reserve(m_flush_interval);
+        m_ref_parts.reserve(m_flush_interval);
+        m_moments.reserve(m_flush_interval);
+    }
 
-                    amrex::ParticleReal tn = 0.4;
-                    pp_diag.queryAdd("tn", tn);
+    void
+    BatchedReducedBeamCharacteristics::operator() (ImpactXParticleContainer const & pc, int step)
+    {
+        BL_PROFILE("impactx::diagnostics::BatchedReducedBeamCharacteristics");
 
-                    amrex::ParticleReal cn = 0.01;
-                    pp_diag.queryAdd("cn", cn);
+        m_steps.push_back(step);
+        m_ref_parts.push_back(pc.GetRefParticle());
+        m_moments.push_back(local_beam_moments(pc));
 
-                    NonlinearLensInvariants const nonlinear_lens_invariants(alpha, beta, tn, cn);
+        if (static_cast<int>(m_steps.size()) >= m_flush_interval) {
+            flush();
+        }
+    }
 
-                    // print out particles (this hack works only on CPU and on GPUs with
-                    // unified memory access)
-                    for (int i = 0; i < np; ++i) {
-                        amrex::ParticleReal const x = part_x[i];
-                        amrex::ParticleReal const y = part_y[i];
-                        uint64_t const global_id = part_idcpu[i];
+    void
+    BatchedReducedBeamCharacteristics::flush ()
+    {
+        BL_PROFILE("impactx::diagnostics::BatchedReducedBeamCharacteristics::flush");
 
-                        amrex::ParticleReal const px = part_px[i];
-                        amrex::ParticleReal const py = part_py[i];
+        if (m_steps.empty()) { return; }
 
-                        // calculate invariants of motion
-                        NonlinearLensInvariants::Data const HI_out =
-                                nonlinear_lens_invariants(x, y, px, py);
+        // one collective for all recorded steps
+        AllReduce(m_moments);
 
-                        // write particle invariant data to file
-                        file_handler
-                                << global_id << " "
-                                << HI_out.H << " " << HI_out.I << "\n";
+        amrex::AllPrintToFile file_handler(m_file_name);
+        file_handler.SetPrecision(std::numeric_limits<amrex::ParticleReal>::max_digits10);
 
-                    } // i=0...np
-                } // end loop over all particle boxes
-            } // end mesh-refinement level loop
+        for (std::size_t i = 0; i < m_steps.size(); ++i) {
+            ReducedBeamCharacteristics const rbc = reduced_beam_characteristics(
+                m_moments[i], m_ref_parts[i], m_compute_eigenemittances);
+            write_reduced_beam_characteristics(file_handler, m_steps[i], m_ref_parts[i].s, rbc);
         }
+
+        m_steps.clear();
+        m_ref_parts.clear();
+        m_moments.clear();
     }
 
 } // namespace impactx::diagnostics
@@ -0,0 +1,372 @@
+/* Copyright 2022-2024 The Regents of the University of California, through Lawrence
+ *           Berkeley National Laboratory (subject to receipt of any required
+ *           approvals from the U.S. Dept. of Energy). All rights reserved.
+ *
+ * This file is part of ImpactX.
+ *
+ * Authors: Axel Huebl, Chad Mitchell
+ * License: BSD-3-Clause-LBNL
+ */
+#include "HaloCharacteristics.H"
+
+#include "BeamMoments.H"
+#include "initialization/Ensemble.H"
+
+#include <AMReX_BLProfiler.H>           // for BL_PROFILE
+#include <AMReX_GpuAtomic.H>            // for Gpu::Atomic::AddNoRet
+#include <AMReX_GpuContainers.H>        // for Gpu::DeviceVector
+#include <AMReX_Math.H>                 // for Math::floor
+#include <AMReX_ParallelDescriptor.H>   // for ParallelDescriptor
+#include <AMReX_ParallelReduce.H>       // for ParallelAllReduce
+#include <AMReX_ParmParse.H>            // for ParmParse
+#include <AMReX_Print.H>                // for PrintToFile
+#include <AMReX_REAL.H>                 // for ParticleReal
+#include <AMReX_Reduce.H>               // for ReduceOps
+#include <AMReX_TypeList.H>             // for TypeMultiplier
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace impactx::diagnostics
+{
+namespace
+{
+    //! number of phase space planes: x, y, t
+    constexpr int nplanes = 3;
+    //! central fourth order moments per plane: q^4, p^4, q^2 p^2, q p^3, q^3 p
+    constexpr int nmoments = 5;
+    //! number of bins in normalized amplitude
+    constexpr int nbins = 4096;
+    //! upper edge of the binned range in units of the RMS amplitude sqrt(2J/emittance)
+    constexpr amrex::ParticleReal r_max = 16.0;
+
+    /** Fourth order moments and amplitude of one particle
+     *
+     * The RMS ellipse of each plane is gamma q^2 + 2 alpha q p + beta p^2 = emittance.
+     */
+    struct HaloKernel
+    {
+        amrex::GpuArray<amrex::ParticleReal, 2 * nplanes> mean; //! mean values in RealSoA order
+        amrex::GpuArray<amrex::ParticleReal, nplanes> alpha, beta, gamma; //! Twiss parameters per plane
+        amrex::GpuArray<amrex::ParticleReal, nplanes> inv_emittance; //! inverse squared RMS emittance per plane, 0 if degenerate
+
+        /** Normalized amplitude 2J/emittance of a plane
+         *
+         * @param k the plane
+         * @param dq deviation of the position from the mean
+         * @param dp deviation of the momentum from the mean
+         */
+        AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE
+        amrex::ParticleReal
+        amplitude (int k, amrex::ParticleReal dq, amrex::ParticleReal dp) const
+        {
+            return (gamma[k] * dq * dq + amrex::ParticleReal(2.0) * alpha[k] * dq * dp + beta[k] * dp * dp) * inv_emittance[k];
+        }
+
+        /** Bin of a normalized amplitude, the last bin collects all larger amplitudes */
+        AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE
+        static int
+        bin (amrex::ParticleReal u)
+        {
+            int const b = int(amrex::Math::floor(std::sqrt(u) * (nbins / r_max)));
+            return b < nbins ? b : nbins;
+        }
+    };
+
+    /** Normalized amplitude at which the CDF reaches a fraction of the total weight
+     *
+     * @param cdf_bins weights per bin, nbins + 1 entries including the overflow bin
+     * @param w_sum total weight
+     * @param fraction the beam fraction
+     * @param u_max the largest normalized amplitude of all particles
+     */
+    amrex::ParticleReal
+    amplitude_of_fraction (amrex::ParticleReal const * cdf_bins,
+                           amrex::ParticleReal w_sum,
+                           amrex::ParticleReal fraction,
+                           amrex::ParticleReal u_max)
+    {
+        amrex::ParticleReal const dr = r_max / nbins;
+        amrex::ParticleReal const target = fraction * w_sum;
+
+        amrex::ParticleReal cumulative = 0.0;
+        for (int b = 0; b <= nbins; ++b) {
+            amrex::ParticleReal const next = cumulative + cdf_bins[b];
+            if (next >= target && cdf_bins[b] > 0.0) {
+                // interpolate linearly in r = sqrt(u) within the bin
+                amrex::ParticleReal const r_lo = b * dr;
+                amrex::ParticleReal const r_hi = b < nbins ? (b + 1) * dr : std::max(r_lo, std::sqrt(u_max));
+                amrex::ParticleReal const r = r_lo + (r_hi - r_lo) * (target - cumulative) / cdf_bins[b];
+                return r * r;
+            }
+            cumulative = next;
+        }
+        return u_max;
+    }
+} // namespace
+
+    std::unordered_map<std::string, amrex::ParticleReal>
+    HaloCharacteristics::to_map () const
+    {
+        char const * const q_names[nplanes] = {"x", "y", "t"};
+        char const * const p_names[nplanes] = {"px", "py", "pt"};
+
+        std::unordered_map<std::string, amrex::ParticleReal> data;
+        for (int k = 0; k < nplanes; ++k) {
+            data[std::string("kurtosis_") + q_names[k]] = kurtosis_q[k];
+            data[std::string("kurtosis_") + p_names[k]] = kurtosis_p[k];
+            data[std::string("halo_") + q_names[k]] = halo[k];
+            for (std::size_t f = 0; f < fractions.size(); ++f) {
+                std::ostringstream percent;
+                percent << fractions[f] * 100.0;
+                data[std::string("emittance_") + q_names[k] + "_" + percent.str()] = emittance_fraction[k][f];
+            }
+        }
+        return data;
+    }
+
+    HaloCharacteristics
+    halo_characteristics (
+        ImpactXParticleContainer const & pc,
+        std::vector<amrex::ParticleReal> const & fractions
+    )
+    {
+        BL_PROFILE("impactx::diagnostics::halo_characteristics");
+
+        using namespace amrex::literals; // for _rt and _prt
+
+        for (amrex::ParticleReal const f : fractions) {
+            if (!(f > 0.0 && f <= 1.0)) {
+                throw std::runtime_error("halo_characteristics: beam fractions must be in (0, 1]!");
+            }
+        }
+
+        // RMS ellipses from the cached second moments
+        BeamMoments const & moments = pc.GetBeamMoments();
+
+        HaloKernel kernel;
+        std::array<amrex::ParticleReal, nplanes> emittance{};
+        for (int d = 0; d < 2 * nplanes; ++d) { kernel.mean[d] = moments.mean[d]; }
+        for (int k = 0; k < nplanes; ++k) {
+            amrex::ParticleReal const qq = moments.covariance(k, k);
+            amrex::ParticleReal const qp = moments.covariance(k, k + nplanes);
+            amrex::ParticleReal const pp = moments.covariance(k + nplanes, k + nplanes);
+            emittance[k] = std::sqrt(std::max(qq * pp - qp * qp, 0.0_prt));
+
+            // unnormalized Twiss parameters: (gamma, alpha, beta) * emittance
+            kernel.gamma[k] = pp;
+            kernel.alpha[k] = -qp;
+            kernel.beta[k] = qq;
+            kernel.inv_emittance[k] = emittance[k] > 0.0_prt ? 1.0_prt / (emittance[k] * emittance[k]) : 0.0_prt;
+        }
+
+        // all sums in one buffer: fourth order moments, then amplitude bins per plane
+        constexpr int nsums = nplanes * nmoments;
+        constexpr int nvalues = nsums + nplanes * (nbins + 1);
+        std::vector<amrex::ParticleReal> sums(nvalues, 0.0);
+        std::array<amrex::ParticleReal, nplanes> u_max{};
+
+        // skip loading the particle weights if they are all equal
+        std::optional<amrex::ParticleReal> const uniform_w = pc.GetUniformWeight();
+        amrex::ParticleReal const w_value = uniform_w.value_or(0.0_prt);
+
+        int const nLevel = pc.finestLevel();
+#if defined(AMREX_USE_GPU)
+        amrex::Gpu::DeviceVector<amrex::ParticleReal> d_bins(nplanes * (nbins + 1), 0.0);
+        amrex::ParticleReal * const AMREX_RESTRICT bins_ptr = d_bins.data();
+
+        amrex::TypeMultiplier<amrex::ReduceOps,
+            amrex::ReduceOpSum[nsums],
+            amrex::ReduceOpMax[nplanes]
+        > reduce_ops;
+        using ReducedDataT = amrex::TypeMultiplier<amrex::ReduceData, amrex::ParticleReal[nsums + nplanes]>;
+        ReducedDataT reduce_data(reduce_ops);
+
+        for (int lev = 0; lev <= nLevel; ++lev) {
+            for (ParConstIterSoA pti(pc, lev); pti.isValid(); ++pti) {
+                int const np = pti.numParticles();
+                auto const & soa = pti.GetStructOfArrays();
+                amrex::GpuArray<amrex::ParticleReal const *, 2 * nplanes> part;
+                for (int d = 0; d < 2 * nplanes; ++d) { part[d] = soa.GetRealData(d).dataPtr(); }
+                amrex::ParticleReal const * const AMREX_RESTRICT part_w =
+                    uniform_w.has_value() ? nullptr : soa.GetRealData(RealSoA::w).dataPtr();
+
+                reduce_ops.eval(np, reduce_data, [=] AMREX_GPU_DEVICE (int i) -> ReducedDataT::Type
+                {
+                    amrex::ParticleReal const w = part_w != nullptr ? part_w[i] : w_value;
+                    ReducedDataT::Type out;
+                    amrex::constexpr_for<0, nplanes>([&](auto k) {
+                        constexpr int ck = decltype(k)::value;
+                        amrex::ParticleReal const dq = part[ck][i] - kernel.mean[ck];
+                        amrex::ParticleReal const dp = part[ck + nplanes][i] - kernel.mean[ck + nplanes];
+                        amrex::get<ck * nmoments + 0>(out) = w * dq * dq * dq * dq;
+                        amrex::get<ck * nmoments + 1>(out) = w * dp * dp * dp * dp;
+                        amrex::get<ck * nmoments + 2>(out) = w * dq * dq * dp * dp;
+                        amrex::get<ck * nmoments + 3>(out) = w * dq * dp * dp * dp;
+                        amrex::get<ck * nmoments + 4>(out) = w * dq * dq * dq * dp;
+
+                        amrex::ParticleReal const u = kernel.amplitude(ck, dq, dp);
+                        amrex::get<nsums + ck>(out) = u;
+                        amrex::Gpu::Atomic::AddNoRet(&bins_ptr[ck * (nbins + 1) + HaloKernel::bin(u)], w);
+                    });
+                    return out;
+                });
+            }
+        }
+
+        auto const r = reduce_data.value(reduce_ops);
+        amrex::constexpr_for<0, nsums>([&](auto n) {
+            sums[decltype(n)::value] = amrex::get<decltype(n)::value>(r);
+        });
+        amrex::constexpr_for<0, nplanes>([&](auto k) {
+            u_max[decltype(k)::value] = amrex::get<nsums + decltype(k)::value>(r);
+        });
+        amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, d_bins.begin(), d_bins.end(), sums.begin() + nsums);
+        amrex::Gpu::streamSynchronize();
+#else
+        for (int lev = 0; lev <= nLevel; ++lev) {
+#ifdef AMREX_USE_OMP
+#pragma omp parallel
+#endif
+            {
+                // thread-private sums, no atomics needed
+                std::vector<amrex::ParticleReal> local_sums(nvalues, 0.0);
+                std::array<amrex::ParticleReal, nplanes> local_u_max{};
+
+                for (ParConstIterSoA pti(pc, lev); pti.isValid(); ++pti) {
+                    int const np = pti.numParticles();
+                    auto const & soa = pti.GetStructOfArrays();
+                    amrex::ParticleReal const * part[2 * nplanes];
+                    for (int d = 0; d < 2 * nplanes; ++d) { part[d] = soa.GetRealData(d).dataPtr(); }
+                    amrex::ParticleReal const * const AMREX_RESTRICT part_w =
+                        uniform_w.has_value() ? nullptr : soa.GetRealData(RealSoA::w).dataPtr();
+
+                    for (int i = 0; i < np; ++i) {
+                        amrex::ParticleReal const w = part_w != nullptr ? part_w[i] : w_value;
+                        for (int k = 0; k < nplanes; ++k) {
+                            amrex::ParticleReal const dq = part[k][i] - kernel.mean[k];
+                            amrex::ParticleReal const dp = part[k + nplanes][i] - kernel.mean[k + nplanes];
+                            amrex::ParticleReal * const m = local_sums.data() + k * nmoments;
+                            m[0] += w * dq * dq * dq * dq;
+                            m[1] += w * dp * dp * dp * dp;
+                            m[2] += w * dq * dq * dp * dp;
+                            m[3] += w * dq * dp * dp * dp;
+                            m[4] += w * dq * dq * dq * dp;
+
+                            amrex::ParticleReal const u = kernel.amplitude(k, dq, dp);
+                            local_u_max[k] = std::max(local_u_max[k], u);
+                            local_sums[nsums + k * (nbins + 1) + HaloKernel::bin(u)] += w;
+                        }
+                    }
+                }
+
+#ifdef AMREX_USE_OMP
+#pragma omp critical (impactx_halo_characteristics)
+#endif
+                {
+                    for (int n = 0; n < nvalues; ++n) { sums[n] += local_sums[n]; }
+                    for (int k = 0; k < nplanes; ++k) { u_max[k] = std::max(u_max[k], local_u_max[k]); }
+                }
+            }
+        }
+#endif
+
+        // merge over all MPI ranks: bins are additive
+        amrex::ParallelAllReduce::Sum(sums.data(), nvalues, amrex::ParallelDescriptor::Communicator());
+        amrex::ParallelAllReduce::Max(u_max.data(), nplanes, amrex::ParallelDescriptor::Communicator());
+
+        HaloCharacteristics halo;
+        halo.fractions = fractions;
+        amrex::ParticleReal const w_sum = moments.w_sum;
+        for (int k = 0; k < nplanes; ++k) {
+            halo.emittance_fraction[k].resize(fractions.size(), 0.0_prt);
+            if (w_sum <= 0.0_prt) { continue; }
+
+            amrex::ParticleReal const * const m = sums.data() + k * nmoments;
+            amrex::ParticleReal const q4 = m[0] / w_sum;
+            amrex::ParticleReal const p4 = m[1] / w_sum;
+            amrex::ParticleReal const q2p2 = m[2] / w_sum;
+            amrex::ParticleReal const qp3 = m[3] / w_sum;
+            amrex::ParticleReal const q3p = m[4] / w_sum;
+
+            amrex::ParticleReal const q2 = moments.covariance(k, k);
+            amrex::ParticleReal const p2 = moments.covariance(k + nplanes, k + nplanes);
+            amrex::ParticleReal const qp = moments.covariance(k, k + nplanes);
+
+            halo.kurtosis_q[k] = q2 > 0.0_prt ? q4 / (q2 * q2) : 0.0_prt;
+            halo.kurtosis_p[k] = p2 > 0.0_prt ? p4 / (p2 * p2) : 0.0_prt;
+
+            // T. P. Wangler and K. R. Crandall, "Beam Halo in Proton Linac Beams," LINAC 2000, and
+            // C. K. Allen and T. P. Wangler, PRST-AB 5, 124202 (2002)
+            amrex::ParticleReal const I2 = q2 * p2 - qp * qp;
+            amrex::ParticleReal const I4 = q4 * p4 + 3.0_prt * q2p2 * q2p2 - 4.0_prt * qp3 * q3p;
+            halo.halo[k] = I2 > 0.0_prt ? std::sqrt(3.0_prt * std::max(I4, 0.0_prt)) / (2.0_prt * I2) - 2.0_prt : 0.0_prt;
+
+            // the ellipse at normalized amplitude u contains emittance u * emittance_rms
+            for (std::size_t f = 0; f < fractions.size(); ++f) {
+                amrex::ParticleReal const u = amplitude_of_fraction(
+                    sums.data() + nsums + k * (nbins + 1), w_sum, fractions[f], u_max[k]);
+                halo.emittance_fraction[k][f] = u * emittance[k];
+            }
+        }
+
+        return halo;
+    }
+
+    void
+    HaloOutput (
+        ImpactXParticleContainer const & pc,
+        int step,
+        bool append
+    )
+    {
+        amrex::ParmParse pp_diag("diag");
+        bool halo_enabled = false;
+        pp_diag.queryAdd("halo", halo_enabled);
+        if (!halo_enabled) { return; }
+
+        BL_PROFILE("impactx::diagnostics::HaloOutput");
+
+        std::vector<amrex::ParticleReal> fractions = {0.9, 0.99, 0.999};
+        pp_diag.queryarr("halo_fractions", fractions);
+
+        HaloCharacteristics const halo = halo_characteristics(pc, fractions);
+        char const * const q_names[nplanes] = {"x", "y", "t"};
+        char const * const p_names[nplanes] = {"px", "py", "pt"};
+
+        // the result is identical on all ranks: write only once
+        amrex::PrintToFile file_handler(initialization::diags_directory() + "/halo_characteristics");
+
+        // column names with the default precision, as in to_map
+        if (!append) {
+            file_handler << "step s";
+            for (int k = 0; k < nplanes; ++k) {
+                file_handler << " kurtosis_" << q_names[k] << " kurtosis_" << p_names[k] << " halo_" << q_names[k];
+            }
+            for (int k = 0; k < nplanes; ++k) {
+                for (amrex::ParticleReal const f : fractions) {
+                    file_handler << " emittance_" << q_names[k] << "_" << f * 100.0;
+                }
+            }
+            file_handler << "\n";
+        }
+
+        file_handler.SetPrecision(std::numeric_limits<amrex::ParticleReal>::max_digits10);
+        file_handler << step << " " << pc.GetRefParticle().s;
+        for (int k = 0; k < nplanes; ++k) {
+            file_handler << " " << halo.kurtosis_q[k] << " " << halo.kurtosis_p[k] << " " << halo.halo[k];
+        }
+        for (int k = 0; k < nplanes; ++k) {
+            for (amrex::ParticleReal const e : halo.emittance_fraction[k]) {
+                file_handler << " " << e;
+            }
+        }
+        file_handler << "\n";
+    }
+
+} // namespace impactx::diagnostics
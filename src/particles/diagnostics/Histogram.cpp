@@ -0,0 +1,360 @@
+/* Copyright 2022-2024 The Regents of the University of California, through Lawrence
+ *           Berkeley National Laboratory (subject to receipt of any required
+ *           approvals from the U.S. Dept. of Energy). All rights reserved.
+ *
+ * This file is part of ImpactX.
+ *
+ * Authors: Axel Huebl, Chad Mitchell
+ * License: BSD-3-Clause-LBNL
+ */
+#include "Histogram.H"
+
+#include "BeamMoments.H"
+#include "initialization/Ensemble.H"
+
+#include <AMReX_BLProfiler.H>           // for BL_PROFILE
+#include <AMReX_GpuAtomic.H>            // for Gpu::Atomic::AddNoRet
+#include <AMReX_GpuContainers.H>        // for Gpu::DeviceVector
+#include <AMReX_GpuLaunch.H>            // for ParallelFor
+#include <AMReX_Math.H>                 // for Math::floor
+#include <AMReX_ParallelDescriptor.H>   // for ParallelDescriptor
+#include <AMReX_ParallelReduce.H>       // for ParallelAllReduce
+#include <AMReX_ParmParse.H>            // for ParmParse
+#include <AMReX_Print.H>                // for PrintToFile
+#include <AMReX_REAL.H>                 // for ParticleReal
+#include <AMReX_Reduce.H>               // for ReduceOps
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+
+namespace impactx::diagnostics
+{
+namespace
+{
+    /** Description of one histogram for the binning kernel */
+    struct HistogramKernelData
+    {
+        int offset = 0; //! first index of this histogram in the bin array
+        int nbins_a = 1, nbins_b = 1; //! number of bins per axis
+        amrex::ParticleReal lo_a = 0, lo_b = 0; //! lower edge per axis
+        amrex::ParticleReal hi_a = 0, hi_b = 0; //! upper edge per axis
+        amrex::ParticleReal inv_da = 1, inv_db = 1; //! inverse bin size per axis
+        amrex::ParticleReal const * AMREX_RESTRICT a = nullptr; //! binned attribute, first axis
+        amrex::ParticleReal const * AMREX_RESTRICT b = nullptr; //! binned attribute, second axis or nullptr
+    };
+
+    /** Bin index along an axis, -1 if outside of the range or not finite */
+    AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE
+    int bin_index (amrex::ParticleReal v, amrex::ParticleReal lo, amrex::ParticleReal hi,
+                   amrex::ParticleReal inv_d, int nbins)
+    {
+        if (!std::isfinite(v) || v < lo || v > hi) { return -1; }
+        amrex::ParticleReal const pos = (v - lo) * inv_d;
+        if (!std::isfinite(pos)) { return -1; }  // infinite range
+        int const bin = int(amrex::Math::floor(pos));
+        return bin < nbins ? bin : nbins - 1;  // upper edge is part of the last bin
+    }
+
+    /** Deposit the particles of one tile into a bin array
+     *
+     * @param bins_ptr bins of all histograms
+     * @param hist_ptr description of all histograms, with attribute pointers of this tile
+     * @param nhist number of histograms
+     * @param weighted count the particle weight (true) or macro particles (false)
+     * @param pti particle tile
+     */
+    void
+    deposit (amrex::ParticleReal * AMREX_RESTRICT bins_ptr,
+             HistogramKernelData const * AMREX_RESTRICT hist_ptr,
+             int nhist,
+             bool weighted,
+             ParConstIterSoA const & pti)
+    {
+        int const np = pti.numParticles();
+        amrex::ParticleReal const * const AMREX_RESTRICT part_w =
+            pti.GetStructOfArrays().GetRealData(RealSoA::w).dataPtr();
+
+        amrex::ParallelFor(np, [=] AMREX_GPU_DEVICE (int i) noexcept
+        {
+            amrex::ParticleReal const w = weighted ? part_w[i] : amrex::ParticleReal(1.0);
+
+            for (int h = 0; h < nhist; ++h) {
+                HistogramKernelData const & kd = hist_ptr[h];
+                int const ia = bin_index(kd.a[i], kd.lo_a, kd.hi_a, kd.inv_da, kd.nbins_a);
+                if (ia < 0) { continue; }
+                int ib = 0;
+                if (kd.b != nullptr) {
+                    ib = bin_index(kd.b[i], kd.lo_b, kd.hi_b, kd.inv_db, kd.nbins_b);
+                    if (ib < 0) { continue; }
+                }
+#if defined(AMREX_USE_GPU)
+                amrex::Gpu::Atomic::AddNoRet(&bins_ptr[kd.offset + ia * kd.nbins_b + ib], w);
+#else
+                bins_ptr[kd.offset + ia * kd.nbins_b + ib] += w;
+#endif
+            }
+        });
+    }
+
+    /** Global min and max of an attribute */
+    std::pair<amrex::ParticleReal, amrex::ParticleReal>
+    auto_range (ImpactXParticleContainer const & pc, int comp)
+    {
+        amrex::ParticleReal lo = std::numeric_limits<amrex::ParticleReal>::max();
+        amrex::ParticleReal hi = std::numeric_limits<amrex::ParticleReal>::lowest();
+
+        if (comp < BeamMoments::ndim) {
+            BeamMoments const & moments = pc.GetBeamMoments();
+            lo = moments.min[comp];
+            hi = moments.max[comp];
+        } else {
+            int const nLevel = pc.finestLevel();
+            for (int lev = 0; lev <= nLevel; ++lev) {
+                for (ParConstIterSoA pti(pc, lev); pti.isValid(); ++pti) {
+                    int const np = pti.numParticles();
+                    amrex::ParticleReal const * const AMREX_RESTRICT part =
+                        pti.GetStructOfArrays().GetRealData(comp).dataPtr();
+
+                    amrex::ReduceOps<amrex::ReduceOpMin, amrex::ReduceOpMax> reduce_op;
+                    amrex::ReduceData<amrex::ParticleReal, amrex::ParticleReal> reduce_data(reduce_op);
+                    reduce_op.eval(np, reduce_data, [=] AMREX_GPU_DEVICE (int i) -> amrex::GpuTuple<amrex::ParticleReal, amrex::ParticleReal>
+                    {
+                        return {part[i], part[i]};
+                    });
+                    auto const r = reduce_data.value(reduce_op);
+                    lo = std::min(lo, amrex::get<0>(r));
+                    hi = std::max(hi, amrex::get<1>(r));
+                }
+            }
+            amrex::ParallelAllReduce::Min(lo, amrex::ParallelDescriptor::Communicator());
+            amrex::ParallelAllReduce::Max(hi, amrex::ParallelDescriptor::Communicator());
+        }
+
+        // no particles or all values identical: use a unit range around the values, like numpy
+        if (lo > hi) { lo = 0.0; hi = 1.0; }
+        if (lo == hi) { lo -= 0.5; hi += 0.5; }
+
+        return {lo, hi};
+    }
+} // namespace
+
+    std::vector<amrex::ParticleReal>
+    Histogram::edges (int axis) const
+    {
+        std::vector<amrex::ParticleReal> e(nbins.at(axis) + 1);
+        amrex::ParticleReal const d = (hi.at(axis) - lo.at(axis)) / nbins.at(axis);
+        for (int i = 0; i <= nbins.at(axis); ++i) {
+            e[i] = lo.at(axis) + i * d;
+        }
+        e.back() = hi.at(axis);
+        return e;
+    }
+
+    std::vector<Histogram>
+    histograms (
+        ImpactXParticleContainer const & pc,
+        std::vector<std::vector<HistogramAxis>> const & axes,
+        bool weighted
+    )
+    {
+        BL_PROFILE("impactx::diagnostics::histograms");
+
+        // describe histograms and their place in one contiguous bin array
+        std::vector<Histogram> hists(axes.size());
+        std::vector<HistogramKernelData> kernel_data(axes.size());
+        int nvalues = 0;
+        for (std::size_t h = 0; h < axes.size(); ++h) {
+            if (axes[h].empty() || axes[h].size() > 2) {
+                throw std::runtime_error("histograms: only 1D and 2D histograms are supported!");
+            }
+            Histogram & hist = hists[h];
+            for (auto const & axis : axes[h]) {
+                if (axis.nbins < 1) {
+                    throw std::runtime_error("histograms: number of bins must be positive!");
+                }
+                auto const [lo, hi] = axis.range.has_value() ? *axis.range : auto_range(pc, axis.comp);
+                if (!(hi > lo)) {
+                    throw std::runtime_error("histograms: upper edge must be larger than lower edge!");
+                }
+                hist.comps.push_back(axis.comp);
+                hist.nbins.push_back(axis.nbins);
+                hist.lo.push_back(lo);
+                hist.hi.push_back(hi);
+            }
+
+            HistogramKernelData & kd = kernel_data[h];
+            kd.offset = nvalues;
+            kd.nbins_a = hist.nbins[0];
+            kd.lo_a = hist.lo[0];
+            kd.hi_a = hist.hi[0];
+            kd.inv_da = kd.nbins_a / (kd.hi_a - kd.lo_a);
+            if (hist.comps.size() == 2) {
+                kd.nbins_b = hist.nbins[1];
+                kd.lo_b = hist.lo[1];
+                kd.hi_b = hist.hi[1];
+                kd.inv_db = kd.nbins_b / (kd.hi_b - kd.lo_b);
+            }
+            nvalues += kd.nbins_a * kd.nbins_b;
+        }
+
+        // with a common weight, count macro particles and scale the counts once
+        std::optional<amrex::ParticleReal> const uniform_w =
+            weighted ? pc.GetUniformWeight() : std::nullopt;
+        bool const load_w = weighted && !uniform_w.has_value();
+
+        std::vector<amrex::ParticleReal> bins(nvalues, 0.0);
+        int const nhist = static_cast<int>(kernel_data.size());
+
+        // attribute pointers of the current tile
+        auto set_tile_pointers = [&] (std::vector<HistogramKernelData> & kd, ParConstIterSoA const & pti)
+        {
+            auto const & soa = pti.GetStructOfArrays();
+            for (int h = 0; h < nhist; ++h) {
+                kd[h].a = soa.GetRealData(hists[h].comps[0]).dataPtr();
+                kd[h].b = hists[h].comps.size() == 2 ? soa.GetRealData(hists[h].comps[1]).dataPtr() : nullptr;
+            }
+        };
+
+        int const nLevel = pc.finestLevel();
+#if defined(AMREX_USE_GPU)
+        amrex::Gpu::DeviceVector<amrex::ParticleReal> d_bins(nvalues, 0.0);
+        amrex::Gpu::DeviceVector<HistogramKernelData> d_kernel_data(nhist);
+        for (int lev = 0; lev <= nLevel; ++lev) {
+            for (ParConstIterSoA pti(pc, lev); pti.isValid(); ++pti) {
+                set_tile_pointers(kernel_data, pti);
+                amrex::Gpu::copyAsync(amrex::Gpu::hostToDevice,
+                                      kernel_data.begin(), kernel_data.end(), d_kernel_data.begin());
+                deposit(d_bins.data(), d_kernel_data.data(), nhist, load_w, pti);
+                amrex::Gpu::streamSynchronize();
+            }
+        }
+        amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, d_bins.begin(), d_bins.end(), bins.begin());
+        amrex::Gpu::streamSynchronize();
+#else
+        for (int lev = 0; lev <= nLevel; ++lev) {
+#ifdef AMREX_USE_OMP
+#pragma omp parallel
+#endif
+            {
+                // thread-private bins, no atomics needed
+                std::vector<amrex::ParticleReal> local_bins(nvalues, 0.0);
+                std::vector<HistogramKernelData> local_kernel_data = kernel_data;
+
+                for (ParConstIterSoA pti(pc, lev); pti.isValid(); ++pti) {
+                    set_tile_pointers(local_kernel_data, pti);
+                    deposit(local_bins.data(), local_kernel_data.data(), nhist, load_w, pti);
+                }
+
+#ifdef AMREX_USE_OMP
+#pragma omp critical (impactx_histograms)
+#endif
+                for (int k = 0; k < nvalues; ++k) {
+                    bins[k] += local_bins[k];
+                }
+            }
+        }
+#endif
+
+        // one collective for all histograms
+        amrex::ParallelAllReduce::Sum(bins.data(), nvalues, amrex::ParallelDescriptor::Communicator());
+        if (uniform_w.has_value()) {
+            for (auto & b : bins) { b *= *uniform_w; }
+        }
+
+        for (int h = 0; h < nhist; ++h) {
+            int const n = kernel_data[h].nbins_a * kernel_data[h].nbins_b;
+            hists[h].values.assign(bins.begin() + kernel_data[h].offset,
+                                   bins.begin() + kernel_data[h].offset + n);
+        }
+
+        return hists;
+    }
+
+    void
+    HistogramOutput (
+        ImpactXParticleContainer & pc,
+        int step,
+        bool append
+    )
+    {
+        HistogramOutput(pc, "diag", initialization::diags_directory() + "/histogram", step, append);
+    }
+
+    void
+    HistogramOutput (
+        ImpactXParticleContainer & pc,
+        std::string const & prefix,
+        std::string const & file_prefix,
+        int step,
+        bool append
+    )
+    {
+        BL_PROFILE("impactx::diagnostics::HistogramOutput");
+
+        amrex::ParmParse pp(prefix);
+        std::vector<std::string> projections;
+        pp.queryarr("histograms", projections);
+        if (projections.empty()) { return; }
+
+        int nbins = 64;
+        pp.queryAdd("histogram_bins", nbins);
+
+        // parse projections of the form attr or attr_a:attr_b
+        std::vector<std::vector<HistogramAxis>> axes;
+        std::vector<std::string> file_names;
+        for (auto const & projection : projections) {
+            std::vector<HistogramAxis> hist_axes;
+            std::string file_name = file_prefix;
+            std::size_t start = 0;
+            while (start <= projection.size()) {
+                std::size_t const end = std::min(projection.find(':', start), projection.size());
+                std::string const attribute = projection.substr(start, end - start);
+                hist_axes.push_back({pc.GetRealCompIndex(attribute), nbins, std::nullopt});
+                file_name += "_" + attribute;
+                start = end + 1;
+            }
+            if (hist_axes.size() > 2) {
+                throw std::runtime_error(prefix + ".histograms: only 1D and 2D histograms are supported, got " + projection);
+            }
+            axes.push_back(hist_axes);
+            file_names.push_back(file_name);
+        }
+
+        std::vector<Histogram> const hists = histograms(pc, axes);
+        amrex::ParticleReal const s = pc.GetRefParticle().s;
+
+        // the result is identical on all ranks: write only once
+        for (std::size_t h = 0; h < hists.size(); ++h) {
+            Histogram const & hist = hists[h];
+
+            amrex::PrintToFile file_handler(file_names[h]);
+            file_handler.SetPrecision(std::numeric_limits<amrex::ParticleReal>::max_digits10);
+
+            if (!append) {
+                file_handler << "step s";
+                for (std::size_t a = 0; a < hist.comps.size(); ++a) {
+                    file_handler << " lo_" << a << " hi_" << a;
+                }
+                file_handler << " values(" << hist.nbins[0];
+                if (hist.nbins.size() == 2) { file_handler << "x" << hist.nbins[1]; }
+                file_handler << ")\n";
+            }
+
+            file_handler << step << " " << s;
+            for (std::size_t a = 0; a < hist.comps.size(); ++a) {
+                file_handler << " " << hist.lo[a] << " " << hist.hi[a];
+            }
+            for (amrex::ParticleReal const v : hist.values) {
+                file_handler << " " << v;
+            }
+            file_handler << "\n";
+        }
+    }
+
+} // namespace impactx::diagnostics
@@ -0,0 +1,393 @@
+/* Copyright 2022-2024 The Regents of the University of California, through Lawrence
+ *           Berkeley National Laboratory (subject to receipt of any required
+ *           approvals from the U.S. Dept. of Energy). All rights reserved.
+ *
+ * This file is part of ImpactX.
+ *
+ * Authors: Axel Huebl, Chad Mitchell
+ * License: BSD-3-Clause-LBNL
+ */
+#include "ProbeParticles.H"
+
+#include "FindSorted.H"
+#include "ReducedBeamCharacteristics.H"
+
+#include <AMReX_BLProfiler.H>           // for BL_PROFILE
+#include <AMReX_GpuContainers.H>        // for Gpu::DeviceVector
+#include <AMReX_ParallelDescriptor.H>   // for ParallelDescriptor, ParallelAllGather
+#include <AMReX_ParallelReduce.H>       // for ParallelAllReduce
+#include <AMReX_Particle.H>             // for ConstParticleIDWrapper, SetParticleIDandCPU
+#include <AMReX_Print.H>                // for PrintToFile
+#include <AMReX_REAL.H>                 // for ParticleReal
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+
+namespace impactx::diagnostics
+{
+namespace
+{
+    /** Number of values per probe particle and step: found flag, x, y, t, px, py, pt */
+    constexpr int num_values = 7;
+
+    /** Normalized transverse amplitude of the particles of a tile
+     *
+     * @param pti particle tile
+     * @param rbc reduced beam characteristics for the Courant-Snyder parameters
+     * @param amplitude output, one value per particle of the tile
+     */
+    void
+    tile_amplitudes (
+        ParConstIterSoA const & pti,
+        ReducedBeamCharacteristics const & rbc,
+        amrex::ParticleReal * amplitude
+    )
+    {
+        using namespace amrex::literals; // for _rt and _prt
+
+        int const np = pti.numParticles();
+        auto const & soa = pti.GetStructOfArrays();
+        amrex::ParticleReal const * const AMREX_RESTRICT part_x = soa.GetRealData(RealSoA::x).dataPtr();
+        amrex::ParticleReal const * const AMREX_RESTRICT part_px = soa.GetRealData(RealSoA::px).dataPtr();
+        amrex::ParticleReal const * const AMREX_RESTRICT part_y = soa.GetRealData(RealSoA::y).dataPtr();
+        amrex::ParticleReal const * const AMREX_RESTRICT part_py = soa.GetRealData(RealSoA::py).dataPtr();
+
+        amrex::ParticleReal const x_mean = rbc.x_mean, px_mean = rbc.px_mean;
+        amrex::ParticleReal const y_mean = rbc.y_mean, py_mean = rbc.py_mean;
+        amrex::ParticleReal const alpha_x = rbc.alpha_x, beta_x = rbc.beta_x;
+        amrex::ParticleReal const alpha_y = rbc.alpha_y, beta_y = rbc.beta_y;
+        amrex::ParticleReal const gamma_x = beta_x > 0.0_prt ? (1.0_prt + alpha_x * alpha_x) / beta_x : 0.0_prt;
+        amrex::ParticleReal const gamma_y = beta_y > 0.0_prt ? (1.0_prt + alpha_y * alpha_y) / beta_y : 0.0_prt;
+        amrex::ParticleReal const inv_emittance_x = rbc.emittance_x > 0.0_prt ? 1.0_prt / rbc.emittance_x : 0.0_prt;
+        amrex::ParticleReal const inv_emittance_y = rbc.emittance_y > 0.0_prt ? 1.0_prt / rbc.emittance_y : 0.0_prt;
+
+        amrex::ParallelFor(np, [=] AMREX_GPU_DEVICE (int i)
+        {
+            amrex::ParticleReal const x = part_x[i] - x_mean;
+            amrex::ParticleReal const px = part_px[i] - px_mean;
+            amrex::ParticleReal const y = part_y[i] - y_mean;
+            amrex::ParticleReal const py = part_py[i] - py_mean;
+
+            amrex::ParticleReal const jx = gamma_x * x * x + 2.0_prt * alpha_x * x * px + beta_x * px * px;
+            amrex::ParticleReal const jy = gamma_y * y * y + 2.0_prt * alpha_y * y * py + beta_y * py * py;
+            amplitude[i] = jx * inv_emittance_x + jy * inv_emittance_y;
+        });
+    }
+
+    /** Copy the probe particles of a tile into the device buffer of one step
+     *
+     * @param pti particle tile
+     * @param idcpu sorted idcpu of the probe particles
+     * @param num_probes number of probe particles
+     * @param buffer device buffer of this step, num_values per probe particle
+     */
+    void
+    record_tile (
+        ParConstIterSoA const & pti,
+        uint64_t const * idcpu,
+        int num_probes,
+        amrex::ParticleReal * buffer
+    )
+    {
+        using namespace amrex::literals; // for _rt and _prt
+
+        int const np = pti.numParticles();
+        auto const & soa = pti.GetStructOfArrays();
+        amrex::ParticleReal const * const AMREX_RESTRICT part_x = soa.GetRealData(RealSoA::x).dataPtr();
+        amrex::ParticleReal const * const AMREX_RESTRICT part_y = soa.GetRealData(RealSoA::y).dataPtr();
+        amrex::ParticleReal const * const AMREX_RESTRICT part_t = soa.GetRealData(RealSoA::t).dataPtr();
+        amrex::ParticleReal const * const AMREX_RESTRICT part_px = soa.GetRealData(RealSoA::px).dataPtr();
+        amrex::ParticleReal const * const AMREX_RESTRICT part_py = soa.GetRealData(RealSoA::py).dataPtr();
+        amrex::ParticleReal const * const AMREX_RESTRICT part_pt = soa.GetRealData(RealSoA::pt).dataPtr();
+        uint64_t const * const AMREX_RESTRICT part_idcpu = soa.GetIdCPUData().dataPtr();
+
+        amrex::ParallelFor(np, [=] AMREX_GPU_DEVICE (int i)
+        {
+            int const probe = detail::find_sorted(idcpu, num_probes, part_idcpu[i]);
+            if (probe < 0) { return; }
+
+            // each probe particle owns its slot: no atomics needed
+            amrex::ParticleReal * const b = buffer + probe * num_values;
+            b[0] = 1.0_prt;
+            b[1] = part_x[i];
+            b[2] = part_y[i];
+            b[3] = part_t[i];
+            b[4] = part_px[i];
+            b[5] = part_py[i];
+            b[6] = part_pt[i];
+        });
+    }
+} // namespace
+
+    std::vector<uint64_t>
+    find_idcpu (
+        ImpactXParticleContainer const & pc,
+        std::vector<amrex::Long> const & ids
+    )
+    {
+        BL_PROFILE("impactx::diagnostics::find_idcpu");
+
+        std::vector<amrex::Long> sorted_ids = ids;
+        std::sort(sorted_ids.begin(), sorted_ids.end());
+        sorted_ids.erase(std::unique(sorted_ids.begin(), sorted_ids.end()), sorted_ids.end());
+        int const num_ids = static_cast<int>(sorted_ids.size());
+
+        // lowest creating rank per id on this rank
+        std::vector<int> cpu(num_ids, std::numeric_limits<int>::max());
+        amrex::Gpu::PinnedVector<uint64_t> h_idcpu;
+        int const nLevel = pc.finestLevel();
+        for (int lev = 0; lev <= nLevel; ++lev) {
+            for (ParConstIterSoA pti(pc, lev); pti.isValid(); ++pti) {
+                int const np = pti.numParticles();
+                auto const & d_idcpu = pti.GetStructOfArrays().GetIdCPUData();
+                h_idcpu.resize(np);
+                amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, d_idcpu.begin(), d_idcpu.begin() + np, h_idcpu.begin());
+                amrex::Gpu::streamSynchronize();
+
+                for (int i = 0; i < np; ++i) {
+                    amrex::Long const id = amrex::ConstParticleIDWrapper{h_idcpu[i]};
+                    int const n = detail::find_sorted(sorted_ids.data(), num_ids, id);
+                    if (n < 0) { continue; }
+                    int const c = amrex::ConstParticleCPUWrapper{h_idcpu[i]};
+                    cpu[n] = std::min(cpu[n], c);
+                }
+            }
+        }
+        amrex::ParallelAllReduce::Min(cpu.data(), num_ids, amrex::ParallelDescriptor::Communicator());
+
+        std::vector<uint64_t> idcpu;
+        for (int n = 0; n < num_ids; ++n) {
+            if (cpu[n] == std::numeric_limits<int>::max()) { continue; }
+            idcpu.push_back(amrex::SetParticleIDandCPU(sorted_ids[n], cpu[n]));
+        }
+        std::sort(idcpu.begin(), idcpu.end());
+        return idcpu;
+    }
+
+    std::vector<uint64_t>
+    largest_amplitude_idcpu (
+        ImpactXParticleContainer const & pc,
+        int num_particles
+    )
+    {
+        BL_PROFILE("impactx::diagnostics::largest_amplitude_idcpu");
+
+        ReducedBeamCharacteristics const rbc = reduced_beam_characteristics(pc);
+
+        // candidates on this rank: amplitude and idcpu
+        std::vector<std::pair<amrex::ParticleReal, uint64_t>> candidates;
+        amrex::Gpu::DeviceVector<amrex::ParticleReal> d_amplitude;
+        amrex::Gpu::PinnedVector<amrex::ParticleReal> h_amplitude;
+        amrex::Gpu::PinnedVector<uint64_t> h_idcpu;
+
+        int const nLevel = pc.finestLevel();
+        for (int lev = 0; lev <= nLevel; ++lev) {
+            for (ParConstIterSoA pti(pc, lev); pti.isValid(); ++pti) {
+                int const np = pti.numParticles();
+                d_amplitude.resize(np);
+                h_amplitude.resize(np);
+                h_idcpu.resize(np);
+                tile_amplitudes(pti, rbc, d_amplitude.dataPtr());
+
+                auto const & d_idcpu = pti.GetStructOfArrays().GetIdCPUData();
+                amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, d_amplitude.begin(), d_amplitude.end(), h_amplitude.begin());
+                amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, d_idcpu.begin(), d_idcpu.begin() + np, h_idcpu.begin());
+                amrex::Gpu::streamSynchronize();
+
+                for (int i = 0; i < np; ++i) {
+                    candidates.emplace_back(h_amplitude[i], h_idcpu[i]);
+                }
+
+                // keep only the local top num_particles
+                if (static_cast<int>(candidates.size()) > 2 * num_particles) {
+                    std::nth_element(candidates.begin(), candidates.begin() + num_particles, candidates.end(),
+                                     std::greater<>());
+                    candidates.resize(num_particles);
+                }
+            }
+        }
+        int const num_local = std::min<int>(num_particles, candidates.size());
+        std::partial_sort(candidates.begin(), candidates.begin() + num_local, candidates.end(), std::greater<>());
+
+        // all ranks exchange their local top candidates, padded to the same count
+        std::vector<amrex::ParticleReal> amplitude(num_particles, -1.0);
+        std::vector<amrex::Long> id(num_particles, -1);
+        std::vector<int> cpu(num_particles, -1);
+        for (int n = 0; n < num_local; ++n) {
+            amplitude[n] = candidates[n].first;
+            id[n] = amrex::ConstParticleIDWrapper{candidates[n].second};
+            cpu[n] = amrex::ConstParticleCPUWrapper{candidates[n].second};
+        }
+        int const nprocs = amrex::ParallelDescriptor::NProcs();
+        std::vector<amrex::ParticleReal> all_amplitude(nprocs * num_particles);
+        std::vector<amrex::Long> all_id(nprocs * num_particles);
+        std::vector<int> all_cpu(nprocs * num_particles);
+        amrex::ParallelAllGather::AllGather(amplitude.data(), num_particles, all_amplitude.data(),
+                                            amrex::ParallelDescriptor::Communicator());
+        amrex::ParallelAllGather::AllGather(id.data(), num_particles, all_id.data(),
+                                            amrex::ParallelDescriptor::Communicator());
+        amrex::ParallelAllGather::AllGather(cpu.data(), num_particles, all_cpu.data(),
+                                            amrex::ParallelDescriptor::Communicator());
+
+        std::vector<int> order(all_id.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int a, int b) {
+            if (all_amplitude[a] != all_amplitude[b]) { return all_amplitude[a] > all_amplitude[b]; }
+            return std::make_pair(all_id[a], all_cpu[a]) < std::make_pair(all_id[b], all_cpu[b]);
+        });
+
+        std::vector<uint64_t> selected;
+        for (int n : order) {
+            if (static_cast<int>(selected.size()) == num_particles) { break; }
+            if (all_id[n] >= 0) { selected.push_back(amrex::SetParticleIDandCPU(all_id[n], all_cpu[n])); }
+        }
+        std::sort(selected.begin(), selected.end());
+        return selected;
+    }
+
+    ProbeParticles::ProbeParticles (std::string file_name,
+                                    std::vector<uint64_t> idcpu,
+                                    int flush_interval)
+        : m_file_name(std::move(file_name)), m_flush_interval(flush_interval), m_idcpu(std::move(idcpu))
+    {
+        if (m_flush_interval < 1) {
+            throw std::runtime_error("ProbeParticles: flush_interval must be positive!");
+        }
+
+        std::sort(m_idcpu.begin(), m_idcpu.end());
+        m_idcpu.erase(std::unique(m_idcpu.begin(), m_idcpu.end()), m_idcpu.end());
+
+        m_d_idcpu.resize(m_idcpu.size());
+        amrex::Gpu::copyAsync(amrex::Gpu::hostToDevice, m_idcpu.begin(), m_idcpu.end(), m_d_idcpu.begin());
+        amrex::Gpu::streamSynchronize();
+    }
+
+    void
+    ProbeParticles::operator() (ImpactXParticleContainer const & pc, int step)
+    {
+        BL_PROFILE("impactx::diagnostics::ProbeParticles::record");
+
+        using namespace amrex::literals; // for _rt and _prt
+
+        int const num_probes = static_cast<int>(m_idcpu.size());
+        if (num_probes == 0) { return; }
+
+        // one block of num_values per probe particle for this step, not found by default
+        std::size_t const offset = m_buffer_steps.size() * num_probes * num_values;
+        m_d_buffer.resize(offset + num_probes * num_values);
+        amrex::ParticleReal * const AMREX_RESTRICT buffer = m_d_buffer.dataPtr() + offset;
+        amrex::ParallelFor(num_probes * num_values, [=] AMREX_GPU_DEVICE (int i) { buffer[i] = 0.0_prt; });
+
+        int const nLevel = pc.finestLevel();
+        for (int lev = 0; lev <= nLevel; ++lev) {
+            for (ParConstIterSoA pti(pc, lev); pti.isValid(); ++pti) {
+                record_tile(pti, m_d_idcpu.dataPtr(), num_probes, buffer);
+            }
+        }
+
+        m_buffer_steps.push_back(step);
+        m_buffer_s.push_back(pc.GetRefParticle().s);
+
+        if (static_cast<int>(m_buffer_steps.size()) >= m_flush_interval) { flush_device(); }
+    }
+
+    void
+    ProbeParticles::flush_device ()
+    {
+        using namespace amrex::literals; // for _rt and _prt
+
+        int const num_probes = static_cast<int>(m_idcpu.size());
+        int const num_steps = static_cast<int>(m_buffer_steps.size());
+        if (num_steps == 0) { return; }
+
+        std::vector<amrex::ParticleReal> h_buffer(m_d_buffer.size());
+        amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, m_d_buffer.begin(), m_d_buffer.end(), h_buffer.begin());
+        amrex::Gpu::streamSynchronize();
+
+        // keep only the probe particles that were found on this rank
+        for (int s = 0; s < num_steps; ++s) {
+            for (int p = 0; p < num_probes; ++p) {
+                amrex::ParticleReal const * const b = h_buffer.data() + (s * num_probes + p) * num_values;
+                if (b[0] == 0.0_prt) { continue; }
+                m_rec_idcpu.push_back(m_idcpu[p]);
+                m_rec_steps.push_back(m_buffer_steps[s]);
+                m_rec_values.push_back(m_buffer_s[s]);
+                m_rec_values.insert(m_rec_values.end(), b + 1, b + num_values);
+            }
+        }
+
+        m_d_buffer.clear();
+        m_buffer_steps.clear();
+        m_buffer_s.clear();
+    }
+
+    void
+    ProbeParticles::write ()
+    {
+        BL_PROFILE("impactx::diagnostics::ProbeParticles::write");
+
+        flush_device();
+
+        // gather all records on the IO rank
+        int const root = amrex::ParallelDescriptor::IOProcessorNumber();
+        int const nprocs = amrex::ParallelDescriptor::NProcs();
+        int const num_local = static_cast<int>(m_rec_idcpu.size());
+
+        std::vector<int> counts(nprocs, 0);
+        amrex::ParallelDescriptor::Gather(&num_local, 1, counts.data(), 1, root);
+        std::vector<int> displs(nprocs, 0);
+        for (int r = 1; r < nprocs; ++r) { displs[r] = displs[r-1] + counts[r-1]; }
+        int const num_total = displs[nprocs-1] + counts[nprocs-1];
+
+        std::vector<int> value_counts(nprocs), value_displs(nprocs);
+        for (int r = 0; r < nprocs; ++r) {
+            value_counts[r] = counts[r] * num_values;
+            value_displs[r] = displs[r] * num_values;
+        }
+
+        // particle id and creating rank, as MPI types
+        std::vector<amrex::Long> rec_ids(num_local);
+        std::vector<int> rec_cpus(num_local);
+        for (int n = 0; n < num_local; ++n) {
+            rec_ids[n] = amrex::ConstParticleIDWrapper{m_rec_idcpu[n]};
+            rec_cpus[n] = amrex::ConstParticleCPUWrapper{m_rec_idcpu[n]};
+        }
+
+        std::vector<amrex::Long> all_ids(num_total);
+        std::vector<int> all_cpus(num_total);
+        std::vector<int> all_steps(num_total);
+        std::vector<amrex::ParticleReal> all_values(std::size_t(num_total) * num_values);
+        amrex::ParallelDescriptor::Gatherv(rec_ids.data(), num_local, all_ids.data(), counts, displs, root);
+        amrex::ParallelDescriptor::Gatherv(rec_cpus.data(), num_local, all_cpus.data(), counts, displs, root);
+        amrex::ParallelDescriptor::Gatherv(m_rec_steps.data(), num_local, all_steps.data(), counts, displs, root);
+        amrex::ParallelDescriptor::Gatherv(m_rec_values.data(), num_local * num_values, all_values.data(),
+                                           value_counts, value_displs, root);
+
+        if (!amrex::ParallelDescriptor::IOProcessor()) { return; }
+
+        // one trajectory per particle
+        std::vector<int> order(num_total);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int a, int b) {
+            return std::make_tuple(all_ids[a], all_cpus[a], all_steps[a]) <
+                   std::make_tuple(all_ids[b], all_cpus[b], all_steps[b]);
+        });
+
+        amrex::PrintToFile file_handler(m_file_name);
+        file_handler.SetPrecision(std::numeric_limits<amrex::ParticleReal>::max_digits10);
+        file_handler << "id cpu step s x y t px py pt\n";
+        for (int n : order) {
+            amrex::ParticleReal const * const v = all_values.data() + std::size_t(n) * num_values;
+            file_handler << all_ids[n] << " " << all_cpus[n] << " " << all_steps[n];
+            for (int c = 0; c < num_values; ++c) { file_handler << " " << v[c]; }
+            file_handler << "\n";
+        }
+    }
+
+} // namespace impactx::diagnostics
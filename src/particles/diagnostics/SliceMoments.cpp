@@ -0,0 +1,176 @@
+/* Copyright 2022-2024 The Regents of the University of California, through Lawrence
+ *           Berkeley National Laboratory (subject to receipt of any required
+ *           approvals from the U.S. Dept. of Energy). All rights reserved.
+ *
+ * This file is part of ImpactX.
+ *
+ * Authors: Axel Huebl, Chad Mitchell
+ * License: BSD-3-Clause-LBNL
+ */
+#include "SliceMoments.H"
+
+#include "BeamMoments.H"
+#include "initialization/Ensemble.H"
+#include "particles/ScratchMemory.H"
+#include "particles/wakefields/ChargeBinning.H"
+
+#include <ablastr/constant.H>
+
+#include <AMReX_BLProfiler.H>           // for BL_PROFILE
+#include <AMReX_GpuContainers.H>        // for Gpu::DeviceVector
+#include <AMReX_ParallelDescriptor.H>   // for ParallelDescriptor
+#include <AMReX_ParallelReduce.H>       // for ParallelAllReduce
+#include <AMReX_Print.H>                // for PrintToFile
+#include <AMReX_REAL.H>                 // for ParticleReal
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+
+namespace impactx::diagnostics
+{
+    std::unordered_map<std::string, std::vector<amrex::ParticleReal>>
+    SliceMoments::to_map () const
+    {
+        return {
+            {"t", t}, {"charge_C", charge_C}, {"current_A", current_A},
+            {"x_mean", x_mean}, {"y_mean", y_mean},
+            {"px_mean", px_mean}, {"py_mean", py_mean}, {"pt_mean", pt_mean},
+            {"sig_x", sig_x}, {"sig_y", sig_y}, {"sig_pt", sig_pt},
+            {"emittance_x", emittance_x}, {"emittance_y", emittance_y},
+            {"emittance_xn", emittance_xn}, {"emittance_yn", emittance_yn}
+        };
+    }
+
+    SliceMoments
+    slice_moments (
+        ImpactXParticleContainer const & pc,
+        int num_bins
+    )
+    {
+        BL_PROFILE("impactx::diagnostics::slice_moments");
+
+        using namespace amrex::literals; // for _rt and _prt
+        using particles::wakefields::num_slice_moments;
+
+        if (num_bins < 1) {
+            throw std::runtime_error("slice_moments: number of bins must be positive!");
+        }
+
+        // slice range and shift from the cached beam moments
+        BeamMoments const & moments = pc.GetBeamMoments();
+        amrex::GpuArray<amrex::ParticleReal, BeamMoments::ndim> shift;
+        for (int d = 0; d < BeamMoments::ndim; ++d) { shift[d] = moments.mean[d]; }
+
+        amrex::Real t_min = moments.min[RealSoA::t];
+        amrex::Real t_max = moments.max[RealSoA::t];
+        if (!(t_max > t_min)) {
+            // no particles or a single slice in t
+            t_min = moments.w_sum > 0.0 ? t_min - 0.5_rt : 0.0_rt;
+            t_max = t_min + 1.0_rt;
+        }
+        // slightly enlarge the bins so that the particle at t_max falls into the last bin
+        amrex::Real const bin_size = (t_max - t_min) / num_bins * (1.0_rt + 4.0_rt * std::numeric_limits<amrex::Real>::epsilon());
+
+        int const num_values = num_bins * num_slice_moments;
+        scratch::Buffer<amrex::Real> d_sums(num_values);
+        particles::wakefields::DepositSliceMoments1D(pc, *d_sums, num_bins, t_min, bin_size, shift);
+
+        std::vector<amrex::Real> sums(num_values);
+        amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, d_sums->begin(), d_sums->end(), sums.begin());
+        amrex::Gpu::streamSynchronize();
+
+        // one collective for all slices
+        amrex::ParallelAllReduce::Sum(sums.data(), num_values, amrex::ParallelDescriptor::Communicator());
+
+        RefPart const & ref_part = pc.GetRefParticle();
+        amrex::ParticleReal const bg = ref_part.beta_gamma();
+        amrex::ParticleReal const q_C = ref_part.charge;
+
+        SliceMoments sm;
+        for (auto * v : {&sm.t, &sm.charge_C, &sm.current_A, &sm.x_mean, &sm.y_mean,
+                         &sm.px_mean, &sm.py_mean, &sm.pt_mean, &sm.sig_x, &sm.sig_y, &sm.sig_pt,
+                         &sm.emittance_x, &sm.emittance_y, &sm.emittance_xn, &sm.emittance_yn}) {
+            v->assign(num_bins, 0.0_prt);
+        }
+
+        for (int b = 0; b < num_bins; ++b) {
+            amrex::Real const * const m = sums.data() + b * num_slice_moments;
+            sm.t[b] = t_min + (b + 0.5_prt) * bin_size;
+
+            amrex::ParticleReal const w = m[0];
+            sm.charge_C[b] = q_C * w;
+            sm.current_A[b] = std::abs(q_C * w) * ablastr::constant::SI::c / bin_size;
+            if (w <= 0.0_prt) { continue; }
+
+            // first moments relative to the shift
+            amrex::ParticleReal const x = m[1] / w, px = m[2] / w;
+            amrex::ParticleReal const y = m[3] / w, py = m[4] / w;
+            amrex::ParticleReal const pt = m[5] / w;
+
+            // central second moments
+            amrex::ParticleReal const xx = std::max(m[6] / w - x * x, 0.0_prt);
+            amrex::ParticleReal const xpx = m[7] / w - x * px;
+            amrex::ParticleReal const pxpx = std::max(m[8] / w - px * px, 0.0_prt);
+            amrex::ParticleReal const yy = std::max(m[9] / w - y * y, 0.0_prt);
+            amrex::ParticleReal const ypy = m[10] / w - y * py;
+            amrex::ParticleReal const pypy = std::max(m[11] / w - py * py, 0.0_prt);
+            amrex::ParticleReal const ptpt = std::max(m[12] / w - pt * pt, 0.0_prt);
+
+            sm.x_mean[b] = shift[RealSoA::x] + x;
+            sm.y_mean[b] = shift[RealSoA::y] + y;
+            sm.px_mean[b] = shift[RealSoA::px] + px;
+            sm.py_mean[b] = shift[RealSoA::py] + py;
+            sm.pt_mean[b] = shift[RealSoA::pt] + pt;
+            sm.sig_x[b] = std::sqrt(xx);
+            sm.sig_y[b] = std::sqrt(yy);
+            sm.sig_pt[b] = std::sqrt(ptpt);
+            sm.emittance_x[b] = std::sqrt(std::max(xx * pxpx - xpx * xpx, 0.0_prt));
+            sm.emittance_y[b] = std::sqrt(std::max(yy * pypy - ypy * ypy, 0.0_prt));
+            sm.emittance_xn[b] = sm.emittance_x[b] * bg;
+            sm.emittance_yn[b] = sm.emittance_y[b] * bg;
+        }
+
+        return sm;
+    }
+
+    void
+    SliceMomentsOutput (
+        ImpactXParticleContainer const & pc,
+        std::string const & name,
+        int num_bins,
+        int step,
+        bool append
+    )
+    {
+        BL_PROFILE("impactx::diagnostics::SliceMomentsOutput");
+
+        SliceMoments const sm = slice_moments(pc, num_bins);
+
+        std::string const file_name = initialization::diags_directory() + "/slice_moments_" + name;
+
+        // the result is identical on all ranks: write only once
+        amrex::PrintToFile file_handler(file_name);
+        file_handler.SetPrecision(std::numeric_limits<amrex::ParticleReal>::max_digits10);
+
+        if (!append) {
+            file_handler << "# t charge_C current_A x_mean y_mean px_mean py_mean pt_mean "
+                         << "sig_x sig_y sig_pt emittance_x emittance_y emittance_xn emittance_yn\n";
+        } else {
+            file_handler << "\n";
+        }
+        file_handler << "# step=" << step << " s=" << pc.GetRefParticle().s << "\n";
+
+        for (int b = 0; b < num_bins; ++b) {
+            file_handler << sm.t[b] << " " << sm.charge_C[b] << " " << sm.current_A[b] << " "
+                         << sm.x_mean[b] << " " << sm.y_mean[b] << " "
+                         << sm.px_mean[b] << " " << sm.py_mean[b] << " " << sm.pt_mean[b] << " "
+                         << sm.sig_x[b] << " " << sm.sig_y[b] << " " << sm.sig_pt[b] << " "
+                         << sm.emittance_x[b] << " " << sm.emittance_y[b] << " "
+                         << sm.emittance_xn[b] << " " << sm.emittance_yn[b] << "\n";
+        }
+    }
+
+} // namespace impactx::diagnostics
@@ -38,24 +38,16 @@ namespace impactx::diagnostics
         if (!enabled)
             return;
 
-        amrex::ParticleReal alpha = 0.0;
-        pp_element.queryAdd("alpha", alpha);
-
-        amrex::ParticleReal beta = 1.0;
-        pp_element.queryAdd("beta", beta);
-
-        amrex::ParticleReal tn = 0.4;
-        pp_element.queryAdd("tn", tn);
-
-        amrex::ParticleReal cn = 0.01;
-        pp_element.queryAdd("cn", cn);
-
-        NonlinearLensInvariants const nonlinear_lens_invariants(alpha, beta, tn, cn);
+        NonlinearLensInvariants const nonlinear_lens_invariants =
+            nonlinear_lens_invariants_from_inputs(element_name);
 
         // profile time spent here
         std::string profile_name = "impactx::Push::" + std::string(BeamMonitor::type) + "::add_optional_properties";
         BL_PROFILE(profile_name);
 
+        // only the runtime properties H and I are written
+        ImpactXParticleContainer::PhaseSpaceUpdate const phase_space_update(pc);
+
         // add runtime properties for H and I
         bool comm = false;
         if (!pc.HasRealComp("H")) {
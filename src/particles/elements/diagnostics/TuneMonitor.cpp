@@ -0,0 +1,282 @@
+/* Copyright 2022-2024 The Regents of the University of California, through Lawrence
+ *           Berkeley National Laboratory (subject to receipt of any required
+ *           approvals from the U.S. Dept. of Energy). All rights reserved.
+ *
+ * This file is part of ImpactX.
+ *
+ * Authors: Axel Huebl, Chad Mitchell
+ * License: BSD-3-Clause-LBNL
+ */
+#include "TuneMonitor.H"
+#include "initialization/Ensemble.H"
+
+#include <AMReX.H>
+#include <AMReX_BLProfiler.H>
+#include <AMReX_GpuContainers.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_Particle.H>
+#include <AMReX_Print.H>
+#include <AMReX_REAL.H>
+#include <AMReX_Utility.H>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace impactx::diagnostics
+{
+namespace
+{
+    /** Number of recorded attributes per particle and turn: x, px, y, py */
+    constexpr int num_planes = 4;
+
+    /** Record x, px, y, py of the tracked particles of a tile for one turn
+     *
+     * @param pti particle tile
+     * @param idcpu sorted idcpu of the tracked particles
+     * @param num_slots number of tracked particles
+     * @param samples turn-by-turn buffer
+     * @param num_samples recorded turns per tracked particle
+     * @param turns number of turns per window
+     * @param turn turn in the window to record
+     */
+    void
+    record_tile (
+        ParConstIterSoA const & pti,
+        uint64_t const * idcpu,
+        int num_slots,
+        amrex::ParticleReal * samples,
+        int * num_samples,
+        int turns,
+        int turn
+    )
+    {
+        int const np = pti.numParticles();
+        auto const & soa = pti.GetStructOfArrays();
+        amrex::ParticleReal const * const AMREX_RESTRICT part_x = soa.GetRealData(RealSoA::x).dataPtr();
+        amrex::ParticleReal const * const AMREX_RESTRICT part_px = soa.GetRealData(RealSoA::px).dataPtr();
+        amrex::ParticleReal const * const AMREX_RESTRICT part_y = soa.GetRealData(RealSoA::y).dataPtr();
+        amrex::ParticleReal const * const AMREX_RESTRICT part_py = soa.GetRealData(RealSoA::py).dataPtr();
+        uint64_t const * const AMREX_RESTRICT part_idcpu = soa.GetIdCPUData().dataPtr();
+
+        amrex::ParallelFor(np, [=] AMREX_GPU_DEVICE (int i)
+        {
+            int const slot = detail::find_sorted(idcpu, num_slots, part_idcpu[i]);
+            if (slot < 0) { return; }
+
+            // each tracked particle owns its slot: no atomics needed
+            amrex::ParticleReal * const s = samples + amrex::Long(slot) * num_planes * turns;
+            s[0 * turns + turn] = part_x[i];
+            s[1 * turns + turn] = part_px[i];
+            s[2 * turns + turn] = part_y[i];
+            s[3 * turns + turn] = part_py[i];
+            num_samples[slot] += 1;
+        });
+    }
+
+    /** Select the particles on this rank that are tracked in the next window
+     *
+     * @param pc particle container
+     * @param particle_stride track every Nth particle by id
+     * @return sorted idcpu of the tracked particles
+     */
+    std::vector<uint64_t>
+    select_particles (
+        ImpactXParticleContainer & pc,
+        int particle_stride
+    )
+    {
+        std::vector<uint64_t> selected;
+        amrex::Gpu::PinnedVector<uint64_t> h_idcpu;
+
+        int const nLevel = pc.finestLevel();
+        for (int lev = 0; lev <= nLevel; ++lev) {
+            for (ParConstIterSoA pti(pc, lev); pti.isValid(); ++pti) {
+                int const np = pti.numParticles();
+                auto const & d_idcpu = pti.GetStructOfArrays().GetIdCPUData();
+                h_idcpu.resize(np);
+                amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, d_idcpu.begin(), d_idcpu.begin() + np, h_idcpu.begin());
+                amrex::Gpu::streamSynchronize();
+
+                for (int i = 0; i < np; ++i) {
+                    amrex::ConstParticleIDWrapper const pid{h_idcpu[i]};
+                    if (!pid.is_valid()) { continue; }
+                    amrex::Long const id = pid;
+                    if ((id - 1) % particle_stride == 0) {
+                        selected.push_back(h_idcpu[i]);
+                    }
+                }
+            }
+        }
+
+        std::sort(selected.begin(), selected.end());
+        return selected;
+    }
+
+    /** Write the tunes of one window, gathered from all MPI ranks
+     *
+     * @param file_name output file
+     * @param append append to an existing file
+     * @param window index of the window
+     * @param step global step at the end of the window
+     * @param id particle ids on this rank
+     * @param qx horizontal tunes on this rank
+     * @param qy vertical tunes on this rank
+     */
+    void
+    write_tunes (
+        std::string const & file_name,
+        bool append,
+        int window,
+        int step,
+        std::vector<amrex::Long> const & id,
+        std::vector<amrex::ParticleReal> const & qx,
+        std::vector<amrex::ParticleReal> const & qy
+    )
+    {
+        int const root = amrex::ParallelDescriptor::IOProcessorNumber();
+        int const nprocs = amrex::ParallelDescriptor::NProcs();
+        int const num_local = static_cast<int>(id.size());
+
+        std::vector<int> counts(nprocs, 0);
+        amrex::ParallelDescriptor::Gather(&num_local, 1, counts.data(), 1, root);
+        std::vector<int> displs(nprocs, 0);
+        for (int r = 1; r < nprocs; ++r) { displs[r] = displs[r-1] + counts[r-1]; }
+        int const num_total = displs[nprocs-1] + counts[nprocs-1];
+
+        std::vector<amrex::Long> all_id(num_total);
+        std::vector<amrex::ParticleReal> all_qx(num_total), all_qy(num_total);
+        amrex::ParallelDescriptor::Gatherv(id.data(), num_local, all_id.data(), counts, displs, root);
+        amrex::ParallelDescriptor::Gatherv(qx.data(), num_local, all_qx.data(), counts, displs, root);
+        amrex::ParallelDescriptor::Gatherv(qy.data(), num_local, all_qy.data(), counts, displs, root);
+
+        amrex::PrintToFile file_handler(file_name);
+        file_handler.SetPrecision(std::numeric_limits<amrex::ParticleReal>::max_digits10);
+        if (!append) {
+            file_handler << "window step id Qx Qy\n";
+        }
+        for (int n = 0; n < num_total; ++n) {
+            file_handler << window << " " << step << " " << all_id[n] << " "
+                         << all_qx[n] << " " << all_qy[n] << "\n";
+        }
+    }
+} // namespace
+
+    TuneMonitor::TuneMonitor (std::string name, int turns, int particle_stride)
+        : m_name(std::move(name)), m_turns(turns), m_particle_stride(particle_stride)
+    {
+        if (m_turns < 2 || (m_turns & (m_turns - 1)) != 0) {
+            throw std::runtime_error("TuneMonitor " + m_name + ": turns must be a power of two, >= 2.");
+        }
+        if (m_particle_stride < 1) {
+            throw std::runtime_error("TuneMonitor " + m_name + ": particle_stride must be >= 1.");
+        }
+    }
+
+    void
+    TuneMonitor::operator() (
+        ImpactXParticleContainer & pc,
+        int step,
+        [[maybe_unused]] int period
+    )
+    {
+        // profile time spent here
+        std::string profile_name = "impactx::Push::" + std::string(TuneMonitor::type) + "::operator()";
+        BL_PROFILE(profile_name);
+
+        detail::TuneBuffer & buffer = m_buffers[m_name];
+
+        // start of a window: select the tracked particles and size the buffer
+        if (buffer.m_turn == 0) {
+            std::vector<uint64_t> const selected = select_particles(pc, m_particle_stride);
+            int const num_slots = static_cast<int>(selected.size());
+
+            buffer.m_idcpu.resize(num_slots);
+            amrex::Gpu::copyAsync(amrex::Gpu::hostToDevice, selected.begin(), selected.end(), buffer.m_idcpu.begin());
+            buffer.m_samples.resize(amrex::Long(num_slots) * num_planes * m_turns);
+            buffer.m_num_samples.resize(num_slots);
+            amrex::Gpu::streamSynchronize();
+
+            int * const AMREX_RESTRICT num_samples = buffer.m_num_samples.dataPtr();
+            amrex::ParallelFor(num_slots, [=] AMREX_GPU_DEVICE (int s) { num_samples[s] = 0; });
+        }
+
+        // record this turn
+        int const num_slots = static_cast<int>(buffer.m_idcpu.size());
+        int const nLevel = pc.finestLevel();
+        for (int lev = 0; lev <= nLevel; ++lev) {
+            // particles own their slots: tiles can be recorded concurrently
+#ifdef AMREX_USE_OMP
+#pragma omp parallel if (amrex::Gpu::notInLaunchRegion())
+#endif
+            for (ParConstIterSoA pti(pc, lev); pti.isValid(); ++pti) {
+                record_tile(pti, buffer.m_idcpu.dataPtr(), num_slots,
+                            buffer.m_samples.dataPtr(), buffer.m_num_samples.dataPtr(),
+                            m_turns, buffer.m_turn);
+            }
+        }
+        buffer.m_turn += 1;
+
+        if (buffer.m_turn < m_turns) { return; }
+
+        // end of a window: compute the tunes of all tracked particles in parallel
+        amrex::Gpu::DeviceVector<amrex::ParticleReal> d_qx(num_slots), d_qy(num_slots);
+        {
+            amrex::ParticleReal * const AMREX_RESTRICT samples = buffer.m_samples.dataPtr();
+            int const * const AMREX_RESTRICT num_samples = buffer.m_num_samples.dataPtr();
+            amrex::ParticleReal * const AMREX_RESTRICT qx = d_qx.dataPtr();
+            amrex::ParticleReal * const AMREX_RESTRICT qy = d_qy.dataPtr();
+            int const turns = m_turns;
+
+            amrex::ParallelFor(num_slots, [=] AMREX_GPU_DEVICE (int s)
+            {
+                // particles that were lost or left this rank have incomplete samples
+                if (num_samples[s] != turns) {
+                    qx[s] = -1.0;
+                    qy[s] = -1.0;
+                    return;
+                }
+                amrex::ParticleReal * const b = samples + amrex::Long(s) * num_planes * turns;
+                qx[s] = detail::interpolated_fft_tune(b, b + turns, turns);
+                qy[s] = detail::interpolated_fft_tune(b + 2 * turns, b + 3 * turns, turns);
+            });
+        }
+
+        std::vector<uint64_t> h_idcpu(num_slots);
+        std::vector<amrex::ParticleReal> h_qx(num_slots), h_qy(num_slots);
+        amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, buffer.m_idcpu.begin(), buffer.m_idcpu.end(), h_idcpu.begin());
+        amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, d_qx.begin(), d_qx.end(), h_qx.begin());
+        amrex::Gpu::copyAsync(amrex::Gpu::deviceToHost, d_qy.begin(), d_qy.end(), h_qy.begin());
+        amrex::Gpu::streamSynchronize();
+
+        // only write particles with a complete window
+        std::vector<amrex::Long> id;
+        std::vector<amrex::ParticleReal> qx, qy;
+        for (int s = 0; s < num_slots; ++s) {
+            if (h_qx[s] < 0.0) { continue; }
+            id.push_back(amrex::Long(amrex::ConstParticleIDWrapper{h_idcpu[s]}));
+            qx.push_back(h_qx[s]);
+            qy.push_back(h_qy[s]);
+        }
+
+        // the tunes are written even if other diagnostics are disabled
+        if (buffer.m_window == 0 && amrex::ParallelDescriptor::IOProcessor()) {
+            amrex::UtilCreateDirectory(initialization::diags_directory(), 0755);
+        }
+        write_tunes(initialization::diags_directory() + "/tunes_" + m_name, buffer.m_window > 0, buffer.m_window, step, id, qx, qy);
+
+        buffer.m_turn = 0;
+        buffer.m_window += 1;
+    }
+
+    void
+    TuneMonitor::finalize ()
+    {
+        m_buffers.erase(m_name);
+    }
+
+} // namespace impactx::diagnostics
@@ -10,11 +10,16 @@
 
 #include "openPMD.H"
 #include "ImpactXVersion.H"
+#include "initialization/Ensemble.H"
 #include "particles/ImpactXParticleContainer.H"
+#include "particles/diagnostics/Histogram.H"
 #include "particles/diagnostics/ReducedBeamCharacteristics.H"
+#include "particles/diagnostics/SliceMoments.H"
 
 #include <AMReX.H>
 #include <AMReX_BLProfiler.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParallelReduce.H>
 #include <AMReX_REAL.H>
 #include <AMReX_ParmParse.H>
 
@@ -139,6 +144,10 @@ namespace detail
 
     void BeamMonitor::finalize ()
     {
+        // the next simulation starts new histogram and slice moments files
+        m_started_files->clear();
+        m_unique_started_files.erase(m_series_name);
+
 #ifdef ImpactX_USE_OPENPMD
         // close shared series alias
         if (m_series.has_value())
@@ -157,6 +166,13 @@ namespace detail
     BeamMonitor::BeamMonitor (std::string series_name, std::string backend, std::string encoding, int period_sample_intervals) :
         m_series_name(std::move(series_name)), m_OpenPMDFileType(std::move(backend)), m_period_sample_intervals(period_sample_intervals)
     {
+        // Ensure m_started_files is the same for the same names.
+        m_started_files = m_unique_started_files[m_series_name].lock();
+        if (!m_started_files) {
+            m_started_files = std::make_shared<std::set<std::string>>();
+            m_unique_started_files[m_series_name] = m_started_files;
+        }
+
 #ifdef ImpactX_USE_OPENPMD
         // pick first available backend if default is chosen
         if( m_OpenPMDFileType == "default" )
@@ -187,7 +203,7 @@ namespace detail
 
         // Ensure m_series is the same for the same names.
         if (m_unique_series.count(m_series_name) == 0u) {
-            std::string filepath = "diags/openPMD/";
+            std::string filepath = initialization::diags_directory() + "/openPMD/";
             filepath.append(m_series_name);
 
             if (series_encoding == openPMD::IterationEncoding::fileBased)
@@ -298,7 +314,11 @@ namespace detail
         {
             for (auto real_idx = 0; real_idx < pc.NumRealComps(); real_idx++) {
                 auto const component_name = real_soa_names.at(real_idx);
-                getComponentRecord(component_name).resetDataset(d_fl);
+                auto rc = getComponentRecord(component_name);
+                rc.resetDataset(d_fl);
+                if (auto const it = m_constant_real_comps.find(real_idx); it != m_constant_real_comps.end()) {
+                    rc.makeConstant(it->second);
+                }
             }
         }
         // SoA: Int
@@ -321,6 +341,30 @@ namespace detail
         if (period % m_period_sample_intervals != 0)
             return;
 
+        // optional: add and calculate additional particle properties
+        add_optional_properties(m_series_name, pc);
+
+        // optional: histograms, e.g., of the nonlinear lens invariants, written independent of openPMD
+        {
+            std::string const file_prefix = initialization::diags_directory() + "/histogram_" + m_series_name;
+            bool const append = m_started_files->count(file_prefix) > 0;
+            m_started_files->insert(file_prefix);
+            HistogramOutput(pc, m_series_name, file_prefix, step, append);
+        }
+
+        // optional: longitudinal slice moments, written independent of openPMD
+        amrex::ParmParse pp_element(m_series_name);
+        bool slice_moments = false;
+        pp_element.queryAdd("slice_moments", slice_moments);
+        if (slice_moments) {
+            int slice_bins = 64;
+            pp_element.queryAdd("slice_bins", slice_bins);
+            std::string const file_name = initialization::diags_directory() + "/slice_moments_" + m_series_name;
+            bool const append = m_started_files->count(file_name) > 0;
+            m_started_files->insert(file_name);
+            SliceMomentsOutput(pc, m_series_name, slice_bins, step, append);
+        }
+
 #ifdef ImpactX_USE_OPENPMD
         std::string profile_name = "impactx::Push::" + std::string(BeamMonitor::type);
         BL_PROFILE(profile_name);
@@ -328,17 +372,26 @@ namespace detail
         // preparing to access reference particle data: RefPart
         RefPart & ref_part = pc.GetRefParticle();
 
-        // optional: add and calculate additional particle properties
-        add_optional_properties(m_series_name, pc);
-
         // optional: calculate total particle bunch information
         m_rbc.clear();
-        m_rbc = diagnostics::reduced_beam_characteristics(pc);
+        m_rbc = diagnostics::reduced_beam_characteristics(pc).to_map();
 
         // component names
         std::vector<std::string> real_soa_names = pc.RealSoA_names();
         std::vector<std::string> int_soa_names = pc.intSoA_names();
 
+        // attributes with a common value for all particles, e.g., a single species
+        // (makeConstant is collective: all ranks must agree on the records)
+        m_constant_real_comps.clear();
+        auto const qm = pc.GetUniformQM();
+        auto const w = pc.GetUniformWeight();
+        int known_qm = qm.has_value() ? 1 : 0;
+        int known_w = w.has_value() ? 1 : 0;
+        amrex::ParallelAllReduce::Min(known_qm, amrex::ParallelDescriptor::Communicator());
+        amrex::ParallelAllReduce::Min(known_w, amrex::ParallelDescriptor::Communicator());
+        if (known_qm == 1) { m_constant_real_comps[RealSoA::qm] = *qm; }
+        if (known_w == 1) { m_constant_real_comps[RealSoA::w] = *w; }
+
         // pinned memory copy
         PinnedContainer pinned_pc = pc.make_alike<amrex::PinnedArenaAllocator>();
         pinned_pc.copyParticles(pc, true);  // no filtering
@@ -425,6 +478,7 @@ namespace detail
         //   SoA floating point (ParticleReal) properties
         {
             for (auto real_idx=0; real_idx < soa.NumRealComps(); real_idx++) {
+                if (m_constant_real_comps.count(real_idx) > 0) { continue; }  // written in prepare
                 auto const component_name = real_soa_names.at(real_idx);
                 getComponentRecord(component_name).storeChunkRaw(
                 soa.GetRealData(real_idx).data(), {offset}, {numParticleOnTile64});
@@ -8,6 +8,7 @@
  * License: BSD-3-Clause-LBNL
  */
 #include "GatherAndPush.H"
+#include "particles/ParallelForParticles.H"
 
 #include <ablastr/particles/NodalFieldGather.H>
 
@@ -27,6 +28,8 @@ namespace impactx::spacecharge
     {
         BL_PROFILE("impactx::spacecharge::GatherAndPush");
 
+        ImpactXParticleContainer::PhaseSpaceUpdate const phase_space_update(pc);
+
         using namespace amrex::literals;
 
         amrex::ParticleReal const charge = pc.GetRefParticle().charge;
@@ -43,8 +46,9 @@ namespace impactx::spacecharge
 
             // loop over all particle boxes
             using ParIt = ImpactXParticleContainer::iterator;
+            [[maybe_unused]] bool const thread_tiles = thread_over_tiles(pc, lev);
 #ifdef AMREX_USE_OMP
-#pragma omp parallel if (amrex::Gpu::notInLaunchRegion())
+#pragma omp parallel if (amrex::Gpu::notInLaunchRegion() && thread_tiles)
 #endif
             for (ParIt pti(pc, lev); pti.isValid(); ++pti) {
                 const int np = pti.numParticles();
@@ -76,7 +80,7 @@ namespace impactx::spacecharge
                 amrex::ParticleReal const push_consts = dt * charge * inv_gamma2 / pz_ref_SI;
 
                 // gather to each particle and push momentum
-                amrex::ParallelFor(np, [=] AMREX_GPU_DEVICE (int i) {
+                ParallelForParticles(np, [=] AMREX_GPU_DEVICE (int i) {
                     // access SoA Real data
                     amrex::ParticleReal & AMREX_RESTRICT x = part_x[i];
                     amrex::ParticleReal & AMREX_RESTRICT y = part_y[i];
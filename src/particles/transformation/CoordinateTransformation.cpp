@@ -11,6 +11,7 @@
 
 #include "ToFixedS.H"
 #include "ToFixedT.H"
+#include "particles/ParallelForParticles.H"
 
 #include <AMReX_BLProfiler.H> // for BL_PROFILE
 #include <AMReX_Extension.H>  // for AMREX_RESTRICT
@@ -25,6 +26,8 @@ namespace impactx::transformation
                                    CoordSystem direction)
     {
         BL_PROFILE("impactx::transformation::CoordinateTransformation");
+
+        ImpactXParticleContainer::PhaseSpaceUpdate const phase_space_update(pc);
         using namespace amrex::literals; // for _rt and _prt
 
         if (direction == CoordSystem::s) {
@@ -42,8 +45,9 @@ namespace impactx::transformation
         for (int lev = 0; lev <= nLevel; ++lev) {
             // loop over all particle boxes
             using ParIt = ImpactXParticleContainer::iterator;
+            [[maybe_unused]] bool const thread_tiles = thread_over_tiles(pc, lev);
 #ifdef AMREX_USE_OMP
-#pragma omp parallel if (amrex::Gpu::notInLaunchRegion())
+#pragma omp parallel if (amrex::Gpu::notInLaunchRegion() && thread_tiles)
 #endif
             for (ParIt pti(pc, lev); pti.isValid(); ++pti) {
                 const int np = pti.numParticles();
@@ -65,7 +69,7 @@ namespace impactx::transformation
                     amrex::ParticleReal const pzd = std::sqrt(std::pow(pd, 2) - 1.0);
 
                     ToFixedS const to_s(pzd);
-                    amrex::ParallelFor(np, [=] AMREX_GPU_DEVICE(long i) {
+                    ParallelForParticles(np, [=] AMREX_GPU_DEVICE(long i) {
                         amrex::ParticleReal &x = part_x[i];
                         amrex::ParticleReal &y = part_y[i];
                         amrex::ParticleReal &z = part_z[i];
@@ -85,7 +89,7 @@ namespace impactx::transformation
                     amrex::ParticleReal const ptd = pd;
 
                     ToFixedT const to_t(ptd);
-                    amrex::ParallelFor(np, [=] AMREX_GPU_DEVICE(long i) {
+                    ParallelForParticles(np, [=] AMREX_GPU_DEVICE(long i) {
                         amrex::ParticleReal &x = part_x[i];
                         amrex::ParticleReal &y = part_y[i];
                         amrex::ParticleReal &t = part_t[i];
@@ -11,10 +11,70 @@
 #include "particles/ImpactXParticleContainer.H"
 
 #include <cmath>
+#include <optional>
+#include <vector>
 
 
 namespace impactx::particles::wakefields
 {
+namespace
+{
+    /** Add the slice moments of the particles in one tile to the bins
+     *
+     * @see DepositSliceMoments1D
+     */
+    void deposit_slice_moments (
+        amrex::Real * AMREX_RESTRICT bins,
+        impactx::ParConstIterSoA const & pti,
+        int num_bins,
+        amrex::Real bin_min,
+        amrex::Real bin_size,
+        amrex::GpuArray<amrex::ParticleReal, 6> const & shift
+    )
+    {
+        using namespace amrex::literals;
+
+        auto const& soa = pti.GetStructOfArrays();
+        long const np = pti.numParticles();
+
+        amrex::ParticleReal const* const AMREX_RESTRICT pos_x = soa.GetRealData(impactx::RealSoA::x).dataPtr();
+        amrex::ParticleReal const* const AMREX_RESTRICT pos_y = soa.GetRealData(impactx::RealSoA::y).dataPtr();
+        amrex::ParticleReal const* const AMREX_RESTRICT pos_z = soa.GetRealData(impactx::RealSoA::z).dataPtr();
+        amrex::ParticleReal const* const AMREX_RESTRICT mom_x = soa.GetRealData(impactx::RealSoA::px).dataPtr();
+        amrex::ParticleReal const* const AMREX_RESTRICT mom_y = soa.GetRealData(impactx::RealSoA::py).dataPtr();
+        amrex::ParticleReal const* const AMREX_RESTRICT mom_t = soa.GetRealData(impactx::RealSoA::pt).dataPtr();
+        amrex::ParticleReal const* const AMREX_RESTRICT d_w = soa.GetRealData(impactx::RealSoA::w).dataPtr();
+
+        amrex::ParallelFor(np, [=] AMREX_GPU_DEVICE(long i)
+        {
+            int const bin = int(amrex::Math::floor((pos_z[i] - bin_min) / bin_size));
+            if (bin < 0 || bin >= num_bins) { return; }
+
+            amrex::Real const w = d_w[i];
+            amrex::Real const x = pos_x[i] - shift[0];
+            amrex::Real const y = pos_y[i] - shift[1];
+            amrex::Real const px = mom_x[i] - shift[3];
+            amrex::Real const py = mom_y[i] - shift[4];
+            amrex::Real const pt = mom_t[i] - shift[5];
+
+            amrex::Real const values[num_slice_moments] = {
+                1.0_rt, x, px, y, py, pt,
+                x * x, x * px, px * px,
+                y * y, y * py, py * py,
+                pt * pt
+            };
+            amrex::Real * const bin_ptr = bins + bin * num_slice_moments;
+            for (int m = 0; m < num_slice_moments; ++m) {
+#if defined(AMREX_USE_GPU)
+                amrex::Gpu::Atomic::AddNoRet(&bin_ptr[m], w * values[m]);
+#else
+                bin_ptr[m] += w * values[m];
+#endif
+            }
+        });
+    }
+} // namespace
+
     void DepositCharge1D (
         impactx::ImpactXParticleContainer& myspc,
         amrex::Gpu::DeviceVector<amrex::Real> & charge_distribution,
@@ -26,6 +86,10 @@ namespace impactx::particles::wakefields
         int const num_bins = charge_distribution.size();
         amrex::Real * const dptr_data = charge_distribution.data();
 
+        // skip loading the particle weights if they are all equal
+        std::optional<amrex::ParticleReal> const uniform_w = myspc.GetUniformWeight();
+        amrex::ParticleReal const w_value = uniform_w.value_or(0.0);
+
         // Loop over each grid level
         int const nlevs = myspc.finestLevel();
         for (int lev = 0; lev <= nlevs; ++lev)
@@ -37,25 +101,26 @@ namespace impactx::particles::wakefields
 #endif
             {
                 // Loop over particles at the current grid level
-                for (impactx::ParIterSoA pti(myspc, lev); pti.isValid(); ++pti)
+                for (impactx::ParConstIterSoA pti(myspc, lev); pti.isValid(); ++pti)
                 {
-                    auto& soa = pti.GetStructOfArrays();  // Access data directly from StructOfArrays (soa)
+                    auto const& soa = pti.GetStructOfArrays();  // Access data directly from StructOfArrays (soa)
 
                     // Number of particles
                     long const np = pti.numParticles();
 
                     // Access particle weights and momenta
-                    amrex::ParticleReal* const AMREX_RESTRICT d_w = soa.GetRealData(impactx::RealSoA::w).dataPtr();
+                    amrex::ParticleReal const* const AMREX_RESTRICT d_w =
+                        uniform_w.has_value() ? nullptr : soa.GetRealData(impactx::RealSoA::w).dataPtr();
 
                     // Access particle positions
-                    amrex::ParticleReal* const AMREX_RESTRICT pos_z = soa.GetRealData(impactx::RealSoA::z).dataPtr();
+                    amrex::ParticleReal const* const AMREX_RESTRICT pos_z = soa.GetRealData(impactx::RealSoA::z).dataPtr();
 
                     // Parallel loop over particles
                     amrex::ParallelFor(np, [=] AMREX_GPU_DEVICE(int i)
                     {
                         // Access particle z-position directly
                         amrex::ParticleReal const z = pos_z[i];  // (Macro)Particle longitudinal position at i
-                        auto const w = amrex::Real(d_w[i]);  // (Macro)Particle weight at i
+                        auto const w = amrex::Real(d_w != nullptr ? d_w[i] : w_value);  // (Macro)Particle weight at i
 
                         /*
                         Weight w is given in [number of electrons]:
@@ -136,6 +201,10 @@ namespace impactx::particles::wakefields
         amrex::Real* const sum_x_ptr = sum_x.data();
         amrex::Real* const sum_y_ptr = sum_y.data();
 
+        // skip loading the particle weights if they are all equal
+        std::optional<amrex::ParticleReal> const uniform_w = myspc.GetUniformWeight();
+        amrex::Real const w_value = uniform_w.value_or(0.0_rt);
+
         int const nlevs = myspc.finestLevel();
         for (int lev = 0; lev <= nlevs; ++lev)
         {
@@ -145,19 +214,20 @@ namespace impactx::particles::wakefields
 #pragma omp parallel if (amrex::Gpu::notInLaunchRegion())
 #endif
             {
-                for (impactx::ParIterSoA pti(myspc, lev); pti.isValid(); ++pti)
+                for (impactx::ParConstIterSoA pti(myspc, lev); pti.isValid(); ++pti)
                 {
-                    auto& soa = pti.GetStructOfArrays();
+                    auto const& soa = pti.GetStructOfArrays();
                     long const np = pti.numParticles();
 
-                    amrex::Real* const AMREX_RESTRICT pos_x = soa.GetRealData(impactx::RealSoA::x).dataPtr();
-                    amrex::Real* const AMREX_RESTRICT pos_y = soa.GetRealData(impactx::RealSoA::y).dataPtr();
-                    amrex::Real* const AMREX_RESTRICT pos_z = soa.GetRealData(impactx::RealSoA::z).dataPtr();
-                    amrex::Real* const AMREX_RESTRICT d_w = soa.GetRealData(impactx::RealSoA::w).dataPtr();
+                    amrex::Real const* const AMREX_RESTRICT pos_x = soa.GetRealData(impactx::RealSoA::x).dataPtr();
+                    amrex::Real const* const AMREX_RESTRICT pos_y = soa.GetRealData(impactx::RealSoA::y).dataPtr();
+                    amrex::Real const* const AMREX_RESTRICT pos_z = soa.GetRealData(impactx::RealSoA::z).dataPtr();
+                    amrex::Real const* const AMREX_RESTRICT d_w =
+                        uniform_w.has_value() ? nullptr : soa.GetRealData(impactx::RealSoA::w).dataPtr();
 
                     amrex::ParallelFor(np, [=] AMREX_GPU_DEVICE(int i)
                     {
-                        amrex::Real const w = d_w[i];
+                        amrex::Real const w = d_w != nullptr ? d_w[i] : w_value;
                         amrex::Real const x = pos_x[i];
                         amrex::Real const y = pos_y[i];
                         amrex::Real const z = pos_z[i];
@@ -189,4 +259,52 @@ namespace impactx::particles::wakefields
             }
         });
     }
+
+    void DepositSliceMoments1D (
+        impactx::ImpactXParticleContainer const & myspc,
+        amrex::Gpu::DeviceVector<amrex::Real> & slice_moments,
+        int num_bins,
+        amrex::Real bin_min,
+        amrex::Real bin_size,
+        amrex::GpuArray<amrex::ParticleReal, 6> const & shift
+    )
+    {
+        using namespace amrex::literals;
+
+        int const num_values = num_bins * num_slice_moments;
+        slice_moments.resize(num_values);
+        amrex::Real * const dptr_moments = slice_moments.data();
+        amrex::ParallelFor(num_values, [=] AMREX_GPU_DEVICE(int i) { dptr_moments[i] = 0.0_rt; });
+
+        int const nlevs = myspc.finestLevel();
+        for (int lev = 0; lev <= nlevs; ++lev)
+        {
+#if defined(AMREX_USE_GPU)
+            for (impactx::ParConstIterSoA pti(myspc, lev); pti.isValid(); ++pti)
+            {
+                deposit_slice_moments(dptr_moments, pti, num_bins, bin_min, bin_size, shift);
+            }
+#else
+#ifdef AMREX_USE_OMP
+#pragma omp parallel
+#endif
+            {
+                // thread-private bins, no atomics needed
+                std::vector<amrex::Real> local_moments(num_values, 0.0_rt);
+
+                for (impactx::ParConstIterSoA pti(myspc, lev); pti.isValid(); ++pti)
+                {
+                    deposit_slice_moments(local_moments.data(), pti, num_bins, bin_min, bin_size, shift);
+                }
+
+#ifdef AMREX_USE_OMP
+#pragma omp critical (impactx_slice_moments)
+#endif
+                for (int i = 0; i < num_values; ++i) {
+                    dptr_moments[i] += local_moments[i];
+                }
+            }
+#endif
+        }
+    }
 }
@@ -9,6 +9,7 @@
  */
 #include "WakeConvolution.H"
 #include "particles/ImpactXParticleContainer.H"
+#include "particles/ScratchMemory.H"
 
 #ifdef ImpactX_USE_FFT
 #include <ablastr/math/fft/AnyFFT.H>
@@ -83,10 +84,10 @@ namespace impactx::particles::wakefields
         // Signal padding for periodicity of FFTs:
         // - slope starts/end on zero, zero-pad the rest
         // - wake function is copied (constructed well defined)
-        amrex::Gpu::DeviceVector<amrex::Real> in1(padded_signal_size, 0.0);
-        amrex::Gpu::DeviceVector<amrex::Real> in2(padded_signal_size, 0.0);
-        amrex::Real * const dptr_in1 = in1.data();
-        amrex::Real * const dptr_in2 = in2.data();
+        scratch::Buffer<amrex::Real> in1(padded_signal_size, 0.0);
+        scratch::Buffer<amrex::Real> in2(padded_signal_size, 0.0);
+        amrex::Real * const dptr_in1 = in1->data();
+        amrex::Real * const dptr_in2 = in2->data();
         amrex::Real const * const dptr_beam_profile_slope = beam_profile_slope.data();
         amrex::Real const * const dptr_wake_func = wake_func.data();
         amrex::ParallelFor(padded_signal_size, [=] AMREX_GPU_DEVICE(int i)
@@ -100,15 +101,15 @@ namespace impactx::particles::wakefields
         });
 
         // Define Forward FFT
-        amrex::Gpu::DeviceVector<Complex> out1(complex_size);
-        amrex::Gpu::DeviceVector<Complex> out2(complex_size);
+        scratch::Buffer<Complex> out1(complex_size);
+        scratch::Buffer<Complex> out2(complex_size);
         // TODO: n does not change usually, so we can keep the plans alive over the simulation
         //       runtime. To do that, we can make this function a functor class.
         auto p1 = ablastr::math::anyfft::CreatePlan(
-                amrex::IntVect(padded_signal_size), in1.data(), out1.data(), ablastr::math::anyfft::direction::R2C, 1
+                amrex::IntVect(padded_signal_size), in1->data(), out1->data(), ablastr::math::anyfft::direction::R2C, 1
         );
         auto p2 = ablastr::math::anyfft::CreatePlan(
-                amrex::IntVect(padded_signal_size), in2.data(), out2.data(), ablastr::math::anyfft::direction::R2C, 1
+                amrex::IntVect(padded_signal_size), in2->data(), out2->data(), ablastr::math::anyfft::direction::R2C, 1
         );
 
         // Perform Forward FFT - Convert inputs into frequency domain
@@ -117,10 +118,10 @@ namespace impactx::particles::wakefields
         ablastr::math::anyfft::Execute(p2);
 
         // Perform FFT Multiplication - FFT Element-wise multiplication in frequency space
-        amrex::Gpu::DeviceVector<Complex> conv_result(complex_size);
-        Complex * const dptr_conv_result = conv_result.data();
-        Complex const * const dptr_out1 = out1.data();
-        Complex const * const dptr_out2 = out2.data();
+        scratch::Buffer<Complex> conv_result(complex_size);
+        Complex * const dptr_conv_result = conv_result->data();
+        Complex const * const dptr_out1 = out1->data();
+        Complex const * const dptr_out2 = out2->data();
         amrex::ParallelFor(complex_size, [=] AMREX_GPU_DEVICE (int i) noexcept
         {
             using ablastr::math::anyfft::multiply;
@@ -128,10 +129,10 @@ namespace impactx::particles::wakefields
         });
 
         // Define Backward FFT - Revert from frequency domain to time/space domain
-        amrex::Gpu::DeviceVector<amrex::Real> out3(padded_signal_size, 0.0);
+        scratch::Buffer<amrex::Real> out3(padded_signal_size, 0.0);
         // TODO: n does not change usually, so we can keep the plans alive over the simulation
         //       runtime. To do that, we can make this function a functor class.
-        amrex::Real * const dptr_out3 = out3.data();
+        amrex::Real * const dptr_out3 = out3->data();
         auto p3 = ablastr::math::anyfft::CreatePlan(
                 amrex::IntVect(padded_signal_size), dptr_out3, dptr_conv_result, ablastr::math::anyfft::direction::C2R, 1
         );
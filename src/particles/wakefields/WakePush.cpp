@@ -8,6 +8,7 @@
  * License: BSD-3-Clause-LBNL
  */
 #include "WakePush.H"
+#include "particles/ParallelForParticles.H"
 
 #include <ablastr/particles/NodalFieldGather.H>
 
@@ -28,6 +29,8 @@ namespace impactx::particles::wakefields
     {
         BL_PROFILE("impactx::particles::wakefields::WakePush")
 
+        ImpactXParticleContainer::PhaseSpaceUpdate const phase_space_update(pc);
+
         using namespace amrex::literals;
 
 #if (defined(AMREX_DEBUG) || defined(DEBUG)) && !defined(AMREX_USE_GPU)
@@ -41,8 +44,9 @@ namespace impactx::particles::wakefields
             // Loop over all particle boxes
             using ParIt = ImpactXParticleContainer::iterator;
 
+            [[maybe_unused]] bool const thread_tiles = thread_over_tiles(pc, lev);
 #ifdef AMREX_USE_OMP
-#pragma omp parallel if (amrex::Gpu::notInLaunchRegion())
+#pragma omp parallel if (amrex::Gpu::notInLaunchRegion() && thread_tiles)
 #endif
             for (ParIt pti(pc, lev); pti.isValid(); ++pti)
             {
@@ -63,7 +67,7 @@ namespace impactx::particles::wakefields
 
                 // Gather particles and push momentum
                 const amrex::Real* wakefield_ptr = convolved_wakefield.data();
-                amrex::ParallelFor(np, [=] AMREX_GPU_DEVICE (int i)
+                ParallelForParticles(np, [=] AMREX_GPU_DEVICE (int i)
                 {
                     // Access SoA Real data
                     amrex::ParticleReal const & AMREX_RESTRICT t = part_t[i];
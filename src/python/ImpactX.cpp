@@ -6,16 +6,20 @@
 #include "pyImpactX.H"
 
 #include <ImpactX.H>
+#include <particles/RefOrbitCache.H>
 #include <particles/transformation/CoordinateTransformation.H>
 
 #include <AMReX.H>
 #include <AMReX_ParmParse.H>
 #include <AMReX_ParallelDescriptor.H>
 
+#include <pybind11/numpy.h>
+
 #if defined(AMREX_DEBUG) || defined(DEBUG)
 #   include <cstdio>
 #endif
 #include <string>
+#include <vector>
 
 
 namespace py = pybind11;
@@ -124,6 +128,20 @@ void init_ImpactX (py::module& m)
             },
             "The maximum mesh-refinement level for the simulation."
         )
+        .def_property("domain_decomposition",
+            [](ImpactX & /* ix */) {
+                return detail::get_or_throw<std::string>("amr", "domain_decomposition");
+            },
+            [](ImpactX & /* ix */, std::string const domain_decomposition) {
+                if (domain_decomposition != "default" && domain_decomposition != "balanced") {
+                    throw std::runtime_error("Domain decomposition must be default or balanced but is: " + domain_decomposition);
+                }
+
+                amrex::ParmParse pp_amr("amr");
+                pp_amr.add("domain_decomposition", domain_decomposition);
+            },
+            "How boxes are laid out and assigned to MPI ranks: default or balanced (by particles per box, updated when the mesh is resized)."
+        )
         .def_property_readonly("finest_level",
             [](ImpactX & ix){ return ix.amr_data->finestLevel(); },
             "The currently finest level of mesh-refinement used. This is always less or equal to max_level."
@@ -154,6 +172,16 @@ void init_ImpactX (py::module& m)
             "The physical extent of the full simulation domain, relative to the reference particle position, in meters."
         )
 
+        .def_property("resize_tolerance",
+            [](ImpactX & /* ix */) {
+                return detail::get_or_throw<amrex::Real>("geometry", "resize_tolerance");
+            },
+            [](ImpactX & /* ix */, amrex::Real const resize_tolerance) {
+                amrex::ParmParse pp_geometry("geometry");
+                pp_geometry.add("resize_tolerance", resize_tolerance);
+            },
+            "Keep the dynamic mesh extent while it deviates from the new extent by at most this fraction of the new extent (default: 0)."
+        )
         .def_property("prob_relative",
               [](ImpactX & /* ix */) {
                   return detail::get_or_throw<amrex::Real>("geometry", "prob_relative");
@@ -243,6 +271,68 @@ void init_ImpactX (py::module& m)
             },
             "The numerical solver to solve the Poisson equation when calculating space charge effects. Either multigrid (default) or fft."
         )
+        .def_property("tracking_dimensions",
+            [](ImpactX & /* ix */) {
+                return detail::get_or_throw<std::string>("algo", "tracking_dimensions");
+            },
+            [](ImpactX & /* ix */, std::string const tracking_dimensions) {
+                if (tracking_dimensions != "6d" && tracking_dimensions != "transverse" && tracking_dimensions != "longitudinal") {
+                    throw std::runtime_error("Tracking dimensions must be 6d, transverse or longitudinal but is: " + tracking_dimensions);
+                }
+
+                amrex::ParmParse pp_algo("algo");
+                pp_algo.add("tracking_dimensions", tracking_dimensions);
+            },
+            "The phase space coordinates pushed in elements that do not couple planes: 6d (default), transverse or longitudinal."
+        )
+        .def_property("local_redistribute",
+            [](ImpactX & /* ix */) {
+                return detail::get_or_throw<int>("algo", "local_redistribute");
+            },
+            [](ImpactX & /* ix */, int const local_redistribute) {
+                amrex::ParmParse pp_algo("algo");
+                pp_algo.add("local_redistribute", local_redistribute);
+            },
+            "If the mesh did not change in a space charge step, redistribute particles only with neighboring boxes within this many cells (default: 0, off)."
+        )
+        .def_property("load_balance_intervals",
+            [](ImpactX & /* ix */) {
+                return detail::get_or_throw<int>("algo", "load_balance_intervals");
+            },
+            [](ImpactX & /* ix */, int const load_balance_intervals) {
+                amrex::ParmParse pp_algo("algo");
+                pp_algo.add("load_balance_intervals", load_balance_intervals);
+            },
+            "Even out the number of particles per MPI rank every this many slice steps, without space charge only (default: 0, off)."
+        )
+        .def_property("load_balance_threshold",
+            [](ImpactX & /* ix */) {
+                return detail::get_or_throw<amrex::Real>("algo", "load_balance_threshold");
+            },
+            [](ImpactX & /* ix */, amrex::Real const load_balance_threshold) {
+                amrex::ParmParse pp_algo("algo");
+                pp_algo.add("load_balance_threshold", load_balance_threshold);
+            },
+            "Rebalance only if the largest number of particles on an MPI rank exceeds this ratio to the average (default: 1.2)."
+        )
+        .def_property("cache_reference_orbit",
+            [](ImpactX & /* ix */) {
+                return detail::get_or_throw<bool>("algo", "cache_reference_orbit");
+            },
+            [](ImpactX & /* ix */, bool const enable) {
+                amrex::ParmParse pp_algo("algo");
+                pp_algo.add("cache_reference_orbit", enable);
+            },
+            "Replay the integrated reference particle push of RF cavities and soft-edge elements from earlier periods and earlier track_particles() calls, until finalize() (default: disabled)."
+        )
+        .def_property_readonly("ref_orbit_cache_hits",
+            [](ImpactX & /* ix */) { return ref_orbit_cache::hits(); },
+            "Number of reference particle pushes replayed from the cache, reset by finalize."
+        )
+        .def_property_readonly("ref_orbit_cache_misses",
+            [](ImpactX & /* ix */) { return ref_orbit_cache::misses(); },
+            "Number of reference particle pushes added to the cache, reset by finalize."
+        )
         .def_property("mlmg_relative_tolerance",
               [](ImpactX & /* ix */) {
                   return detail::get_or_throw<bool>("algo", "mlmg_relative_tolerance");
@@ -328,6 +418,99 @@ void init_ImpactX (py::module& m)
              "The minimum number of digits (default: 6) used for the step\n"
              "number appended to the diagnostic file names."
         )
+        .def_property("diag_batch_reductions",
+             [](ImpactX & /* ix */) {
+                 return detail::get_or_throw<int>("diag", "batch_reductions");
+             },
+             [](ImpactX & /* ix */, int const batch_reductions) {
+                 amrex::ParmParse pp_diag("diag");
+                 pp_diag.add("batch_reductions", batch_reductions);
+             },
+             "Number of steps (default: 1) for which the reduced beam characteristics\n"
+             "are accumulated per MPI rank before they are reduced in one collective and written."
+        )
+        .def_property("diag_history",
+             [](ImpactX & /* ix */) {
+                 std::vector<std::string> history;
+                 amrex::ParmParse pp_diag("diag");
+                 pp_diag.queryarr("history", history);
+                 return history;
+             },
+             [](ImpactX & /* ix */, std::vector<std::string> const & history) {
+                 amrex::ParmParse pp_diag("diag");
+                 pp_diag.addarr("history", history);
+             },
+             "Reduced beam characteristics kept in memory in history, e.g., [\"emittance_x\", \"beta_x\"] or [\"all\"]."
+        )
+        .def_property("diag_histograms",
+             [](ImpactX & /* ix */) {
+                 std::vector<std::string> histograms;
+                 amrex::ParmParse pp_diag("diag");
+                 pp_diag.queryarr("histograms", histograms);
+                 return histograms;
+             },
+             [](ImpactX & /* ix */, std::vector<std::string> const & histograms) {
+                 amrex::ParmParse pp_diag("diag");
+                 pp_diag.addarr("histograms", histograms);
+             },
+             "Phase space projections written as histograms, e.g., [\"position_x:momentum_x\", \"position_t\"]."
+        )
+        .def_property("diag_histogram_bins",
+             [](ImpactX & /* ix */) {
+                 return detail::get_or_throw<int>("diag", "histogram_bins");
+             },
+             [](ImpactX & /* ix */, int const histogram_bins) {
+                 amrex::ParmParse pp_diag("diag");
+                 pp_diag.add("histogram_bins", histogram_bins);
+             },
+             "Number of bins per axis of the histograms in diag_histograms (default: 64)."
+        )
+        .def_property("diag_halo",
+             [](ImpactX & /* ix */) {
+                 return detail::get_or_throw<bool>("diag", "halo");
+             },
+             [](ImpactX & /* ix */, bool const halo) {
+                 amrex::ParmParse pp_diag("diag");
+                 pp_diag.add("halo", halo);
+             },
+             "Enable or disable the output of halo characteristics (default: disabled)."
+        )
+        .def_property("diag_halo_fractions",
+             [](ImpactX & /* ix */) {
+                 std::vector<amrex::ParticleReal> fractions = {0.9, 0.99, 0.999};
+                 amrex::ParmParse pp_diag("diag");
+                 pp_diag.queryarr("halo_fractions", fractions);
+                 return fractions;
+             },
+             [](ImpactX & /* ix */, std::vector<amrex::ParticleReal> const & fractions) {
+                 amrex::ParmParse pp_diag("diag");
+                 pp_diag.addarr("halo_fractions", fractions);
+             },
+             "Beam fractions of the fractional emittances in the halo characteristics (default: [0.9, 0.99, 0.999])."
+        )
+        .def_property("diag_probe_ids",
+             [](ImpactX & /* ix */) {
+                 std::vector<amrex::Long> ids;
+                 amrex::ParmParse pp_diag("diag");
+                 pp_diag.queryarr("probe_ids", ids);
+                 return ids;
+             },
+             [](ImpactX & /* ix */, std::vector<amrex::Long> const & ids) {
+                 amrex::ParmParse pp_diag("diag");
+                 pp_diag.addarr("probe_ids", ids);
+             },
+             "Ids of probe particles whose trajectories are written to diags/probe_particles (default: none)."
+        )
+        .def_property("diag_probe_largest_amplitude",
+             [](ImpactX & /* ix */) {
+                 return detail::get_or_throw<int>("diag", "probe_largest_amplitude");
+             },
+             [](ImpactX & /* ix */, int num_particles) {
+                 amrex::ParmParse pp_diag("diag");
+                 pp_diag.add("probe_largest_amplitude", num_particles);
+             },
+             "Number of probe particles with the largest initial transverse amplitudes (default: 0)."
+        )
         .def_property("particle_lost_diagnostics_backend",
                       [](ImpactX & /* ix */) {
                           return detail::get_or_throw<std::string>("diag", "backend");
@@ -390,6 +573,50 @@ void init_ImpactX (py::module& m)
             "Controls how much information is printed to the terminal, when running ImpactX.\n"
             "``0`` for silent, higher is more verbose. Default is ``1``."
         )
+        .def_property("report_affinity",
+            [](ImpactX & /* ix */){
+                return detail::get_or_throw<bool>("impactx", "report_affinity");
+            },
+            [](ImpactX & /* ix */, bool const report_affinity) {
+                amrex::ParmParse pp_impactx("impactx");
+                pp_impactx.add("report_affinity", report_affinity);
+            },
+            "Print the CPU of each OpenMP thread per MPI rank in init_grids (default: disabled)."
+        )
+        .def_property("tile_threading",
+            [](ImpactX & /* ix */){
+                return detail::get_or_throw<std::string>("impactx", "tile_threading");
+            },
+            [](ImpactX & /* ix */, std::string const tile_threading) {
+                if (tile_threading != "auto" && tile_threading != "tiles" && tile_threading != "split") {
+                    throw std::runtime_error("Tile threading must be auto, tiles or split but is: " + tile_threading);
+                }
+
+                amrex::ParmParse pp_impactx("impactx");
+                pp_impactx.add("tile_threading", tile_threading);
+            },
+            "How OpenMP threads share the work on particle tiles: auto (default), tiles or split."
+        )
+        .def_property("autotune",
+            [](ImpactX & /* ix */){
+                return detail::get_or_throw<bool>("impactx", "autotune");
+            },
+            [](ImpactX & /* ix */, bool const autotune) {
+                amrex::ParmParse pp_impactx("impactx");
+                pp_impactx.add("autotune", autotune);
+            },
+            "Choose the fastest OpenMP configuration for particle pushes at the start of tracking (default: disabled)."
+        )
+        .def_property("particle_huge_pages",
+            [](ImpactX & /* ix */){
+                return detail::get_or_throw<bool>("impactx", "particle_huge_pages");
+            },
+            [](ImpactX & /* ix */, bool const particle_huge_pages) {
+                amrex::ParmParse pp_impactx("impactx");
+                pp_impactx.add("particle_huge_pages", particle_huge_pages);
+            },
+            "Back new particle arrays on CPUs with transparent huge pages (default: disabled)."
+        )
 
         .def("deposit_charge",
             [](ImpactX & ix) {
@@ -408,6 +635,7 @@ void init_ImpactX (py::module& m)
                 ix.amr_data->m_particle_container->Redistribute();
 
                 // charge deposition
+                ix.amr_data->AllocateFields();
                 ix.amr_data->m_particle_container->DepositCharge(ix.amr_data->m_rho, ix.amr_data->refRatio());
 
                 // transform from x,y,z to x',y',t
@@ -443,7 +671,7 @@ void init_ImpactX (py::module& m)
         )
 
         .def("resize_mesh", &ImpactX::ResizeMesh,
-             "Resize the mesh :py:attr:`~domain` based on the :py:attr:`~dynamic_size` and related parameters."
+             "Resize the mesh :py:attr:`~domain` based on the :py:attr:`~dynamic_size` and related parameters. Returns True if the mesh changed."
         )
 
         .def("particle_container",
@@ -453,16 +681,41 @@ void init_ImpactX (py::module& m)
              py::return_value_policy::reference_internal,
              "Access the beam particle container."
         )
+        .def_property_readonly("mpi_comm_f",
+             [](ImpactX const & /* ix */) -> int {
+#ifdef AMREX_USE_MPI
+                return static_cast<int>(MPI_Comm_c2f(amrex::ParallelDescriptor::Communicator()));
+#else
+                return -1;
+#endif
+             },
+             "Fortran handle of the MPI communicator of this simulation, e.g., for mpi4py.MPI.Comm.f2py.\n\n"
+             "In an ensemble of simulations, this is the communicator of the current member. -1 without MPI."
+        )
+        .def("particle_container_lost",
+             [](ImpactX & ix) -> ImpactXParticleContainer & {
+                return *ix.amr_data->m_particles_lost;
+             },
+             py::return_value_policy::reference_internal,
+             "Access the container of particles lost in apertures.\n\n"
+             "Lost particles have the additional attributes s_lost and period_lost."
+        )
         .def(
             "rho",
-            [](ImpactX & ix, int const lev) { return &ix.amr_data->m_rho.at(lev); },
+            [](ImpactX & ix, int const lev) {
+                ix.amr_data->AllocateFields();
+                return &ix.amr_data->m_rho.at(lev);
+            },
             py::arg("lev"),
             py::return_value_policy::reference_internal,
             "charge density per level"
         )
         .def(
             "phi",
-            [](ImpactX & ix, int const lev) { return &ix.amr_data->m_phi.at(lev); },
+            [](ImpactX & ix, int const lev) {
+                ix.amr_data->AllocateFields();
+                return &ix.amr_data->m_phi.at(lev);
+            },
             py::arg("lev"),
             py::return_value_policy::reference_internal,
             "scalar potential per level"
@@ -470,12 +723,28 @@ void init_ImpactX (py::module& m)
         .def(
             "space_charge_field",
             [](ImpactX & ix, int lev, std::string const & comp) {
+                ix.amr_data->AllocateFields();
                 return &ix.amr_data->m_space_charge_field.at(lev).at(comp);
             },
             py::arg("lev"), py::arg("comp"),
             py::return_value_policy::reference_internal,
             "space charge force (vector: x,y,z) per level"
         )
+        .def_property_readonly("history",
+            [](ImpactX & ix) {
+                py::dict history;
+                for (auto const & [key, values] : ix.m_history) {
+                    history[py::str(key)] = py::array_t<amrex::ParticleReal>(values.size(), values.data());
+                }
+                return history;
+            },
+            "In-memory history of the reduced beam characteristics selected in diag_history.\n\n"
+            "A dict of numpy arrays, with one entry per diagnostics step, including \"step\" and \"s\"."
+        )
+        .def("clear_history",
+            [](ImpactX & ix) { ix.m_history.clear(); },
+            "Remove all recorded values from the in-memory history."
+        )
         .def_readwrite("lattice",
             &ImpactX::m_lattice,
             "Access the accelerator element lattice."
@@ -492,6 +761,26 @@ void init_ImpactX (py::module& m)
               },
               "The number of periods to repeat the lattice."
         )
+        .def_property("stop_when_all_lost",
+              [](ImpactX & /* ix */) {
+                  return detail::get_or_throw<bool>("lattice", "stop_when_all_lost");
+              },
+              [](ImpactX & /* ix */, bool stop_when_all_lost) {
+                  amrex::ParmParse pp_lattice("lattice");
+                  pp_lattice.add("stop_when_all_lost", stop_when_all_lost);
+              },
+              "Stop tracking after the period in which all particles were lost."
+        )
+        .def_property("simplify_lattice",
+              [](ImpactX & /* ix */) {
+                  return detail::get_or_throw<bool>("lattice", "simplify");
+              },
+              [](ImpactX & /* ix */, bool simplify) {
+                  amrex::ParmParse pp_lattice("lattice");
+                  pp_lattice.add("simplify", simplify);
+              },
+              "Remove no-op elements and merge adjacent drifts and thin kicks before tracking."
+        )
 
         // from AmrCore->AmrMesh
         .def("Geom",
@@ -6,14 +6,22 @@
 #include "pyImpactX.H"
 
 #include <particles/ImpactXParticleContainer.H>
+#include <particles/diagnostics/HaloCharacteristics.H>
+#include <particles/diagnostics/Histogram.H>
 #include <particles/diagnostics/ReducedBeamCharacteristics.H>
+#include <particles/diagnostics/SliceMoments.H>
 
 #include <AMReX.H>
 #include <AMReX_MFIter.H>
 #include <AMReX_ParticleContainer.H>
 
+#include <pybind11/numpy.h>
+
 #include <algorithm>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace py = pybind11;
@@ -59,6 +67,23 @@ void init_impactxparticlecontainer(py::module& m)
             &ImpactXParticleContainer::GetCoordSystem,
             "Get the current coordinate system of particles in this container"
         )
+        .def_property_readonly("uniform_qm",
+            &ImpactXParticleContainer::GetUniformQM,
+            "The charge over mass ratio in 1/eV shared by all particles, or None if not uniform or unknown"
+        )
+        .def_property_readonly("uniform_weight",
+            &ImpactXParticleContainer::GetUniformWeight,
+            "The weight shared by all particles, or None if not uniform or unknown"
+        )
+        .def("update_uniform_attributes",
+            &ImpactXParticleContainer::UpdateUniformAttributes,
+            "Detect if qm and w have the same value for all particles.\n\n"
+            "This is called at the start of track_particles. This is an MPI collective operation."
+        )
+        .def("reset_uniform_attributes",
+            &ImpactXParticleContainer::ResetUniformAttributes,
+            "Forget the uniform values of qm and w, e.g., after modifying them."
+        )
 
         // simpler particle iterator loops: return types of this particle box
         // note: overwritten to return ImpactX instead of (py)AMReX iterators
@@ -113,10 +138,80 @@ void init_impactxparticlecontainer(py::module& m)
         )
         .def("reduced_beam_characteristics",
              [](ImpactXParticleContainer & pc) {
-                 return diagnostics::reduced_beam_characteristics(pc);
+                 return diagnostics::reduced_beam_characteristics(pc).to_map();
              },
              "Compute reduced beam characteristics like the position and momentum moments of the particle distribution, as well as emittance and Twiss parameters."
         )
+        .def("slice_moments",
+             [](ImpactXParticleContainer & pc, int bins) {
+                 py::dict result;
+                 for (auto const & [key, values] : diagnostics::slice_moments(pc, bins).to_map()) {
+                     result[py::str(key)] = py::array_t<amrex::ParticleReal>(values.size(), values.data());
+                 }
+                 return result;
+             },
+             py::arg("bins") = 64,
+             "Compute characteristics of longitudinal slices of the beam, binned in t, in one pass over all particles.\n\n"
+             ":param bins: number of slices\n"
+             ":return: slice properties with string keywords, each an array with one value per slice"
+        )
+        .def("halo_characteristics",
+             [](ImpactXParticleContainer & pc, std::vector<amrex::ParticleReal> const & fractions) {
+                 return diagnostics::halo_characteristics(pc, fractions).to_map();
+             },
+             py::arg("fractions") = std::vector<amrex::ParticleReal>{0.9, 0.99, 0.999},
+             "Compute halo characteristics of the particle distribution: kurtosis, halo parameter and\n"
+             "emittances containing a fraction of the beam, e.g., emittance_x_99 for 99% of the beam."
+        )
+        .def("histograms",
+             [](ImpactXParticleContainer & pc,
+                std::vector<std::vector<std::string>> const & projections,
+                int bins,
+                std::optional<std::vector<std::vector<std::pair<amrex::ParticleReal, amrex::ParticleReal>>>> const & ranges,
+                bool weighted
+             ) {
+                 if (ranges && ranges->size() != projections.size()) {
+                     throw std::runtime_error("histograms: need one list of ranges per projection!");
+                 }
+
+                 std::vector<std::vector<diagnostics::HistogramAxis>> axes;
+                 for (std::size_t h = 0; h < projections.size(); ++h) {
+                     if (ranges && (*ranges)[h].size() != projections[h].size()) {
+                         throw std::runtime_error("histograms: need one range per attribute!");
+                     }
+                     std::vector<diagnostics::HistogramAxis> hist_axes;
+                     for (std::size_t a = 0; a < projections[h].size(); ++a) {
+                         diagnostics::HistogramAxis axis{pc.GetRealCompIndex(projections[h][a]), bins, std::nullopt};
+                         if (ranges) { axis.range = (*ranges)[h][a]; }
+                         hist_axes.push_back(axis);
+                     }
+                     axes.push_back(hist_axes);
+                 }
+
+                 py::list result;
+                 for (auto const & hist : diagnostics::histograms(pc, axes, weighted)) {
+                     std::vector<py::ssize_t> shape(hist.nbins.begin(), hist.nbins.end());
+                     py::array_t<amrex::ParticleReal> values(shape);
+                     std::copy(hist.values.begin(), hist.values.end(), values.mutable_data());
+
+                     py::list edges;
+                     for (std::size_t a = 0; a < hist.nbins.size(); ++a) {
+                         auto const e = hist.edges(int(a));
+                         edges.append(py::array_t<amrex::ParticleReal>(e.size(), e.data()));
+                     }
+                     result.append(py::make_tuple(values, edges));
+                 }
+                 return result;
+             },
+             py::arg("projections"), py::arg("bins") = 64, py::arg("ranges") = py::none(), py::arg("weighted") = true,
+             "Compute 1D and 2D histograms of particle attributes in one pass over all particles.\n\n"
+             "The result is reduced over all MPI ranks.\n\n"
+             ":param projections: list of projections, each a list of one or two attribute names, e.g., [[\"position_x\", \"momentum_x\"]]\n"
+             ":param bins: number of bins per axis\n"
+             ":param ranges: optional list of (lower, upper) edges per attribute for each projection, default: min and max of the attribute\n"
+             ":param weighted: count the particle weights instead of macro particles\n"
+             ":return: list with a tuple (values, [edges]) per projection, like numpy.histogram2d"
+        )
 
         .def("redistribute",
              &ImpactXParticleContainer::Redistribute,
@@ -267,10 +267,71 @@ void init_elements(py::module& m)
             },
             "Scale factor (in meters^(1/2)) of the IOTA nonlinear magnetic insert element used for computing H and I."
         )
+        .def_property("histograms",
+            [](diagnostics::BeamMonitor & bm) {
+                std::vector<std::string> histograms;
+                amrex::ParmParse pp_element(bm.series_name());
+                pp_element.queryarr("histograms", histograms);
+                return histograms;
+            },
+            [](diagnostics::BeamMonitor & bm, std::vector<std::string> const & histograms) {
+                amrex::ParmParse pp_element(bm.series_name());
+                pp_element.addarr("histograms", histograms);
+            },
+            "Particle attributes written as histograms to diags/histogram_<name>_<attribute>, e.g., [\"H\", \"I\", \"H:I\"]"
+        )
+        .def_property("histogram_bins",
+            [](diagnostics::BeamMonitor & bm) { return detail::get_or_throw<int>(bm.series_name(), "histogram_bins"); },
+            [](diagnostics::BeamMonitor & bm, int histogram_bins) {
+                amrex::ParmParse pp_element(bm.series_name());
+                pp_element.add("histogram_bins", histogram_bins);
+            },
+            "Number of bins per axis of the histograms (default: 64)"
+        )
+        .def_property("slice_moments",
+            [](diagnostics::BeamMonitor & bm) { return detail::get_or_throw<bool>(bm.series_name(), "slice_moments"); },
+            [](diagnostics::BeamMonitor & bm, bool slice_moments) {
+                amrex::ParmParse pp_element(bm.series_name());
+                pp_element.add("slice_moments", slice_moments);
+            },
+            "Compute and output characteristics of longitudinal slices of the beam to diags/slice_moments_<name>"
+        )
+        .def_property("slice_bins",
+            [](diagnostics::BeamMonitor & bm) { return detail::get_or_throw<int>(bm.series_name(), "slice_bins"); },
+            [](diagnostics::BeamMonitor & bm, int slice_bins) {
+                amrex::ParmParse pp_element(bm.series_name());
+                pp_element.add("slice_bins", slice_bins);
+            },
+            "Number of longitudinal slices for slice_moments (default: 64)"
+        )
     ;
 
     register_beamoptics_push(py_BeamMonitor);
 
+    py::class_<diagnostics::TuneMonitor, elements::Thin> py_TuneMonitor(me, "TuneMonitor");
+    py_TuneMonitor
+        .def(py::init<std::string, int, int>(),
+             py::arg("name"),
+             py::arg("turns") = 1024,
+             py::arg("particle_stride") = 1,
+             "This element computes betatron tunes of beam particles over turns."
+        )
+        .def_property_readonly("name",
+            &diagnostics::TuneMonitor::name,
+            "name of the monitor"
+        )
+        .def_property_readonly("turns",
+            &diagnostics::TuneMonitor::turns,
+            "number of turns per window"
+        )
+        .def_property_readonly("particle_stride",
+            &diagnostics::TuneMonitor::particle_stride,
+            "only every Nth particle by id is tracked"
+        )
+    ;
+
+    register_beamoptics_push(py_TuneMonitor);
+
     // beam optics
 
     py::class_<Aperture, elements::Named, elements::Thin, elements::Alignment> py_Aperture(me, "Aperture");
@@ -1043,6 +1104,7 @@ void init_elements(py::module& m)
                 amrex::ParticleReal,
                 int,
                 int,
+                amrex::ParticleReal,
                 std::optional<std::string>
              >(),
              py::arg("ds"),
@@ -1056,6 +1118,7 @@ void init_elements(py::module& m)
              py::arg("rotation") = 0,
              py::arg("mapsteps") = 1,
              py::arg("nslice") = 1,
+             py::arg("map_tolerance") = 0,
              py::arg("name") = py::none(),
              "An RF cavity."
         )
@@ -1081,6 +1144,10 @@ void init_elements(py::module& m)
             [](RFCavity & rfc, int mapsteps) { rfc.m_mapsteps = mapsteps; },
             "number of integration steps per slice used for map and reference particle push in applied fields"
         )
+        .def_property_readonly("map_tolerance",
+            [](RFCavity & rfc) { return rfc.m_map_tolerance; },
+            "local error tolerance in m used to place the integration steps instead of mapsteps, off if not positive"
+        )
     ;
     register_beamoptics_push(py_RFCavity);
 
@@ -1276,6 +1343,7 @@ void init_elements(py::module& m)
                  amrex::ParticleReal,
                  int,
                  int,
+                 amrex::ParticleReal,
                  std::optional<std::string>
              >(),
              py::arg("ds"),
@@ -1288,6 +1356,7 @@ void init_elements(py::module& m)
              py::arg("rotation") = 0,
              py::arg("mapsteps") = 1,
              py::arg("nslice") = 1,
+             py::arg("map_tolerance") = 0,
              py::arg("name") = py::none(),
              "A soft-edge solenoid."
         )
@@ -1308,6 +1377,10 @@ void init_elements(py::module& m)
             [](SoftSolenoid & soft_sol, int mapsteps) { soft_sol.m_mapsteps = mapsteps; },
             "number of integration steps per slice used for map and reference particle push in applied fields"
         )
+        .def_property_readonly("map_tolerance",
+            [](SoftSolenoid & soft_sol) { return soft_sol.m_map_tolerance; },
+            "local error tolerance in m used to place the integration steps instead of mapsteps, off if not positive"
+        )
     ;
     register_beamoptics_push(py_SoftSolenoid);
 
@@ -1403,6 +1476,7 @@ void init_elements(py::module& m)
                  amrex::ParticleReal,
                  int,
                  int,
+                 amrex::ParticleReal,
                  std::optional<std::string>
              >(),
              py::arg("ds"),
@@ -1414,6 +1488,7 @@ void init_elements(py::module& m)
              py::arg("rotation") = 0,
              py::arg("mapsteps") = 1,
              py::arg("nslice") = 1,
+             py::arg("map_tolerance") = 0,
              py::arg("name") = py::none(),
              "A soft-edge quadrupole."
         )
@@ -1429,6 +1504,10 @@ void init_elements(py::module& m)
             [](SoftQuadrupole & soft_quad, int mapsteps) { soft_quad.m_mapsteps = mapsteps; },
             "number of integration steps per slice used for map and reference particle push in applied fields"
         )
+        .def_property_readonly("map_tolerance",
+            [](SoftQuadrupole & soft_quad) { return soft_quad.m_map_tolerance; },
+            "local error tolerance in m used to place the integration steps instead of mapsteps, off if not positive"
+        )
     ;
     register_beamoptics_push(py_SoftQuadrupole);
 
@@ -0,0 +1,141 @@
+"""
+This file is part of ImpactX
+
+Copyright 2024 ImpactX contributors
+Authors: Axel Huebl
+License: BSD-3-Clause-LBNL
+"""
+
+
+def ix_dynamic_aperture(self, x, y, turns, px=0.0, py=0.0, pt=0.0, root_rank=0):
+    """
+    Dynamic aperture scan over a grid of initial amplitudes.
+
+    One particle per pair of initial x and y is tracked through up to
+    ``turns`` periods of the lattice.  Particles lost in apertures are moved
+    to the lost particle container with the period in which they were lost,
+    the surviving particles continue on compacted arrays and the tracking
+    stops early when all particles are lost.
+
+    The simulation must be initialized (``init_grids``), the reference
+    particle and the lattice must be set and no beam particles may exist yet.
+
+    Parameters
+    ----------
+    self : ImpactX
+        The ImpactX simulation
+    x : array_like
+        Initial horizontal amplitudes in m
+    y : array_like
+        Initial vertical amplitudes in m
+    turns : int
+        Maximum number of periods (turns) to track
+    px, py, pt : float, default=0.0
+        Initial momenta of all particles
+    root_rank : int, default=0
+        MPI rank that returns the result.
+
+    Returns
+    -------
+    Number of completed turns per initial amplitude, as a numpy array of
+    shape ``(len(x), len(y))``.  Surviving particles have ``turns``.
+    For MPI-parallel runs, the result is only returned on the root_rank.
+    """
+    from inspect import getmodule
+
+    import numpy as np
+
+    import amrex.space3d as amr
+
+    ix = getmodule(self)
+    comm = None
+    rank = 0
+    nprocs = 1
+    if ix.Config.have_mpi:
+        from mpi4py import MPI
+
+        comm = MPI.Comm.f2py(self.mpi_comm_f)
+        rank = comm.Get_rank()
+        nprocs = comm.Get_size()
+
+    pc = self.particle_container()
+    pc_lost = self.particle_container_lost()
+    num_existing = pc.total_number_of_particles() + pc_lost.total_number_of_particles()
+    if num_existing > 0:
+        raise RuntimeError("dynamic_aperture: the particle containers must be empty.")
+
+    # grid of initial amplitudes, each rank adds a contiguous part of it
+    xx, yy = np.meshgrid(
+        np.asarray(x, dtype=float), np.asarray(y, dtype=float), indexing="ij"
+    )
+    npart = xx.size
+    local = np.array_split(np.arange(npart), nprocs)[rank]
+    nlocal = local.size
+    coords = [
+        xx.ravel()[local],
+        yy.ravel()[local],
+        np.zeros(nlocal),
+        np.full(nlocal, px),
+        np.full(nlocal, py),
+        np.full(nlocal, pt),
+    ]
+
+    podvs = []
+    for values in coords:
+        if ix.Config.have_gpu:
+            podv = amr.PODVector_real_arena()
+        else:
+            podv = amr.PODVector_real_std()
+        podv.resize(nlocal)
+        if nlocal > 0:
+            if ix.Config.have_gpu:
+                podv.to_cupy()[:] = values
+            else:
+                podv.to_numpy()[:] = values
+        podvs.append(podv)
+
+    # each macro particle represents one physical particle
+    ref = pc.ref_particle()
+    qm_eev = ref.charge_qe / (ref.mass_MeV * 1.0e6)
+    charge_C = abs(ref.charge_qe) * 1.602176634e-19 * nlocal
+    pc.add_n_particles(*podvs, qm_eev, charge_C)
+
+    self.periods = turns
+    self.stop_when_all_lost = True
+    self.track_particles()
+
+    # survived turns per particle, wherever the particle is now
+    idcpu = []
+    survived = []
+    df = pc.to_df(local=True)
+    if df is not None and len(df) > 0:
+        idcpu.append(df["idcpu"].to_numpy())
+        survived.append(np.full(len(df), turns))
+    df_lost = pc_lost.to_df(local=True)
+    if df_lost is not None and len(df_lost) > 0:
+        idcpu.append(df_lost["idcpu"].to_numpy())
+        survived.append(df_lost["period_lost"].to_numpy().astype(int))
+
+    idcpu = np.concatenate(idcpu) if idcpu else np.zeros(0, dtype=np.uint64)
+    survived = np.concatenate(survived) if survived else np.zeros(0, dtype=int)
+
+    if comm is not None:
+        parts = comm.gather((idcpu, survived), root=root_rank)
+        if rank != root_rank:
+            return None
+        idcpu = np.concatenate([p[0] for p in parts])
+        survived = np.concatenate([p[1] for p in parts])
+
+    # the rank that added a particle holds the grid part of that rank, and
+    # particle ids on a rank increase in the order the particles were added
+    ids = (idcpu >> np.uint64(24)) & np.uint64(0x7FFFFFFFFF)
+    cpus = idcpu & np.uint64(0xFFFFFF)
+    survived = survived[np.lexsort((ids, cpus))]
+
+    return survived.reshape(xx.shape)
+
+
+def register_ImpactX_extension(ix):
+    """ImpactX helper methods"""
+    # register member functions for ImpactX
+    ix.dynamic_aperture = ix_dynamic_aperture
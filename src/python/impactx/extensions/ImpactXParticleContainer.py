@@ -7,7 +7,7 @@ License: BSD-3-Clause-LBNL
 """
 
 
-def ix_pc_plot_mpl_phasespace(self, num_bins=50, root_rank=0):
+def ix_pc_plot_mpl_phasespace(self, num_bins=50, root_rank=0, weighted=False):
     """
     Plot the longitudinal and transverse phase space projections with matplotlib.
 
@@ -18,7 +18,9 @@ def ix_pc_plot_mpl_phasespace(self, num_bins=50, root_rank=0):
     num_bins : int, default=50
         The number of bins for spatial and momentum directions per plot axis.
     root_rank : int, default=0
-        MPI root rank to reduce to in parallel runs.
+        MPI rank that creates the figure in parallel runs.
+    weighted : bool, default=False
+        Count the particle weights instead of macro particles.
 
     Returns
     -------
@@ -37,85 +39,24 @@ def ix_pc_plot_mpl_phasespace(self, num_bins=50, root_rank=0):
     rad2mrad = 1.0e3
 
     # Data Histogramming
-    df = self.to_df(local=True)
-
-    # calculate local histograms
-    if df is None:
-        xpx = np.zeros(
-            (
-                num_bins,
-                num_bins,
-            )
-        )
-        x_edges = np.linspace(rbc["x_min"] * m2mm, rbc["x_max"] * m2mm, num_bins + 1)
-        px_edges = np.linspace(
-            rbc["px_min"] * rad2mrad, rbc["px_max"] * rad2mrad, num_bins + 1
-        )
-
-        ypy = np.zeros(
-            (
-                num_bins,
-                num_bins,
-            )
-        )
-        y_edges = np.linspace(rbc["y_min"] * m2mm, rbc["y_max"] * m2mm, num_bins + 1)
-        py_edges = np.linspace(
-            rbc["py_min"] * rad2mrad, rbc["py_max"] * rad2mrad, num_bins + 1
-        )
-
-        tpt = np.zeros(
-            (
-                num_bins,
-                num_bins,
-            )
-        )
-        t_edges = np.linspace(rbc["t_min"] * m2mm, rbc["t_max"] * m2mm, num_bins + 1)
-        pt_edges = np.linspace(
-            rbc["pt_min"] * rad2mrad, rbc["pt_max"] * rad2mrad, num_bins + 1
-        )
-    else:
-        # update for plot unit system
-        # TODO: normalize to t/z to um and mc depending on s or t
-        df.position_x = df.position_x.multiply(m2mm)
-        df.position_y = df.position_y.multiply(m2mm)
-        df.position_t = df.position_t.multiply(m2mm)
-
-        df.momentum_x = df.momentum_x.multiply(rad2mrad)
-        df.momentum_y = df.momentum_y.multiply(rad2mrad)
-        df.momentum_t = df.momentum_t.multiply(rad2mrad)
-
-        xpx, x_edges, px_edges = np.histogram2d(
-            df["position_x"],
-            df["momentum_x"],
-            bins=num_bins,
-            range=[
-                [rbc["x_min"] * m2mm, rbc["x_max"] * m2mm],
-                [rbc["px_min"] * rad2mrad, rbc["px_max"] * rad2mrad],
-            ],
-        )
-
-        ypy, y_edges, py_edges = np.histogram2d(
-            df["position_y"],
-            df["momentum_y"],
-            bins=num_bins,
-            range=[
-                [rbc["y_min"] * m2mm, rbc["y_max"] * m2mm],
-                [rbc["py_min"] * rad2mrad, rbc["py_max"] * rad2mrad],
-            ],
-        )
-
-        tpt, t_edges, pt_edges = np.histogram2d(
-            df["position_t"],
-            df["momentum_t"],
-            bins=num_bins,
-            range=[
-                [rbc["t_min"] * m2mm, rbc["t_max"] * m2mm],
-                [rbc["pt_min"] * rad2mrad, rbc["pt_max"] * rad2mrad],
-            ],
-        )
+    #   computed in one pass over all particles and reduced over all MPI ranks
+    #   in ImpactX, without copying the particle data to Python
+    hists = self.histograms(
+        [
+            ["position_x", "momentum_x"],
+            ["position_y", "momentum_y"],
+            ["position_t", "momentum_t"],
+        ],
+        bins=num_bins,
+        weighted=weighted,
+        ranges=[
+            [(rbc["x_min"], rbc["x_max"]), (rbc["px_min"], rbc["px_max"])],
+            [(rbc["y_min"], rbc["y_max"]), (rbc["py_min"], rbc["py_max"])],
+            [(rbc["t_min"], rbc["t_max"]), (rbc["pt_min"], rbc["pt_max"])],
+        ],
+    )
 
-    # MPI reduce
-    #   nothing to do for non-MPI runs
+    # the result is available on all ranks: plot only once
     from inspect import getmodule
 
     ix = getmodule(self)
@@ -123,26 +64,20 @@ def ix_pc_plot_mpl_phasespace(self, num_bins=50, root_rank=0):
         from mpi4py import MPI
 
         comm = MPI.COMM_WORLD  # TODO: get currently used ImpactX communicator here
-        rank = comm.Get_rank()
-
-        # MPI_Reduce the node-local histogram data
-        combined_data = np.concatenate([xpx, ypy, tpt])
-        summed_data = comm.reduce(
-            combined_data,
-            op=MPI.SUM,
-            root=root_rank,
-        )
-
-        if rank != root_rank:
+        if comm.Get_rank() != root_rank:
             return None
 
-        [xpx, ypy, tpt] = np.split(
-            summed_data,
-            [
-                len(xpx),
-                len(xpx) + len(ypy),
-            ],
-        )
+    # update for plot unit system
+    # TODO: normalize to t/z to um and mc depending on s or t
+    (xpx, (x_edges, px_edges)) = hists[0]
+    (ypy, (y_edges, py_edges)) = hists[1]
+    (tpt, (t_edges, pt_edges)) = hists[2]
+    x_edges, y_edges, t_edges = x_edges * m2mm, y_edges * m2mm, t_edges * m2mm
+    px_edges, py_edges, pt_edges = (
+        px_edges * rad2mrad,
+        py_edges * rad2mrad,
+        pt_edges * rad2mrad,
+    )
 
     # histograms per axis
     x = np.sum(xpx, axis=1)
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import numpy as np
+
+from impactx import ImpactX, distribution, elements
+
+
+def track(tile_threading, autotune=False):
+    """Track a FODO cell, returns the final beam and the tile threading used"""
+    sim = ImpactX()
+
+    sim.particle_shape = 2
+    sim.space_charge = False
+    sim.slice_step_diagnostics = False
+    sim.diagnostics = False
+    sim.tile_threading = tile_threading
+    sim.autotune = autotune
+    sim.init_grids()
+
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(2.0e3)
+
+    distr = distribution.Waterbag(
+        lambdaX=3.9984884770e-5,
+        lambdaY=3.9984884770e-5,
+        lambdaT=1.0e-3,
+        lambdaPx=2.6623538760e-5,
+        lambdaPy=2.6623538760e-5,
+        lambdaPt=2.0e-3,
+    )
+    sim.add_particles(1.0e-9, distr, 10000)
+
+    sim.lattice.extend(
+        [
+            elements.Drift(name="d1", ds=0.25),
+            elements.Quad(name="q1", ds=1.0, k=1.0),
+            elements.Drift(name="d2", ds=0.5),
+            elements.Quad(name="q2", ds=1.0, k=-1.0),
+            elements.Drift(name="d3", ds=0.25),
+        ]
+    )
+    sim.track_particles()
+
+    beam = pc.to_df(local=True).sort_values("idcpu").reset_index(drop=True)
+    used = sim.tile_threading
+    sim.finalize()
+    return beam, used
+
+
+def test_tile_threading():
+    """
+    All tile threading modes and the autotuner push the beam identically
+    """
+    beam, _ = track("tiles")
+    for tile_threading in ["split", "auto"]:
+        beam_other, _ = track(tile_threading)
+        for column in ["position_x", "position_t", "momentum_x", "momentum_t"]:
+            assert np.array_equal(beam[column], beam_other[column]), column
+
+    # the autotuner chooses one of the modes and does not push the beam itself
+    beam_tuned, used = track("auto", autotune=True)
+    assert used in ["auto", "tiles", "split"]
+    for column in ["position_x", "position_t", "momentum_x", "momentum_t"]:
+        assert np.array_equal(beam[column], beam_tuned[column]), column
+
+
+if __name__ == "__main__":
+    test_tile_threading()
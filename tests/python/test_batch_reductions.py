@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+from impactx import ImpactX, distribution, elements
+
+
+def track(batch_reductions):
+    """Track a short FODO cell with slice step diagnostics, returns the diagnostics files"""
+    sim = ImpactX()
+
+    sim.particle_shape = 2
+    sim.space_charge = False
+    sim.diagnostics = True
+    sim.slice_step_diagnostics = True
+    sim.diag_batch_reductions = batch_reductions
+    sim.init_grids()
+
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(2.0e3)
+
+    distr = distribution.Waterbag(
+        lambdaX=3.9984884770e-5,
+        lambdaY=3.9984884770e-5,
+        lambdaT=1.0e-3,
+        lambdaPx=2.6623538760e-5,
+        lambdaPy=2.6623538760e-5,
+        lambdaPt=2.0e-3,
+    )
+    sim.add_particles(1.0e-9, distr, 1000)
+
+    # 13 slice steps: not a multiple of the batch size
+    sim.lattice.extend(
+        [
+            elements.Drift(name="d1", ds=0.25, nslice=2),
+            elements.Quad(name="q1", ds=1.0, k=1.0, nslice=4),
+            elements.Drift(name="d2", ds=0.5, nslice=3),
+            elements.Quad(name="q2", ds=1.0, k=-1.0, nslice=4),
+        ]
+    )
+    sim.track_particles()
+
+    files = {}
+    for name in ["reduced_beam_characteristics", "ref_particle"]:
+        with open(f"diags/{name}.0") as f:
+            files[name] = f.read()
+
+    sim.finalize()
+    return files
+
+
+def test_batch_reductions():
+    """
+    Batching the reductions of the reduced beam characteristics writes the same files
+    """
+    unbatched = track(1)
+    batched = track(4)
+
+    # header, initial step and one line per slice step
+    assert len(unbatched["reduced_beam_characteristics"].splitlines()) == 1 + 1 + 13
+
+    for name, content in unbatched.items():
+        assert batched[name] == content, name
+
+
+if __name__ == "__main__":
+    test_batch_reductions()
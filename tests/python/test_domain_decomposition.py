@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import math
+
+import numpy as np
+
+from impactx import ImpactX, amr, distribution, elements
+
+
+def track(domain_decomposition):
+    """Track an expanding beam with space charge, returns the number of boxes, particles and moments"""
+    sim = ImpactX()
+
+    sim.n_cell = [16, 16, 16]
+    sim.blocking_factor_x = [4]
+    sim.blocking_factor_y = [4]
+    sim.blocking_factor_z = [4]
+    sim.domain_decomposition = domain_decomposition
+    pp_amr = amr.ParmParse("amr")
+    pp_amr.add("boxes_per_rank", 8)
+
+    sim.particle_shape = 2
+    sim.space_charge = True
+    sim.poisson_solver = "fft"
+    sim.dynamic_size = True
+    sim.prob_relative = [1.2]
+    sim.slice_step_diagnostics = False
+    sim.diagnostics = False
+    sim.init_grids()
+
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(250.0)
+
+    distr = distribution.Kurth6D(
+        lambdaX=4.472135955e-4,
+        lambdaY=4.472135955e-4,
+        lambdaT=9.12241869e-7,
+        lambdaPx=0.0,
+        lambdaPy=0.0,
+        lambdaPt=0.0,
+    )
+    npart = 10000
+    sim.add_particles(1.0e-9, distr, npart)
+
+    sim.lattice.append(elements.Drift(name="d1", ds=1.0, nslice=10))
+    sim.track_particles()
+
+    num_boxes = sim.boxArray(lev=0).size
+    num_particles = pc.total_number_of_particles()
+    rbc = pc.reduced_beam_characteristics()
+
+    # the charge of all particles is deposited on the balanced boxes
+    sim.deposit_charge()
+    rho = sim.rho(lev=0)
+    dV = np.prod(sim.Geom(lev=0).data().CellSize())
+    beam_charge = dV * rho.sum_unique(comp=0, local=False)
+    assert math.isclose(beam_charge, -1.0e-9, rel_tol=1.0e-8)
+
+    sim.finalize()
+    return num_boxes, num_particles, rbc
+
+
+def test_domain_decomposition():
+    """
+    Space charge with the balanced domain decomposition agrees with the default one
+    """
+    default_boxes, default_particles, default_rbc = track("default")
+    balanced_boxes, balanced_particles, balanced_rbc = track("balanced")
+
+    # at least amr.boxes_per_rank boxes
+    assert balanced_boxes >= 8
+    assert balanced_boxes > default_boxes
+
+    assert balanced_particles == default_particles == 10000
+    for key in ["sig_x", "sig_y", "sig_t", "emittance_x", "emittance_y", "emittance_t"]:
+        assert np.isclose(balanced_rbc[key], default_rbc[key], rtol=1.0e-8, atol=0), key
+
+
+if __name__ == "__main__":
+    test_domain_decomposition()
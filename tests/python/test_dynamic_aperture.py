@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# Authors: Axel Huebl
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import math
+
+import numpy as np
+
+from impactx import ImpactX, amr, elements
+
+
+def make_sim():
+    """Drift and aperture: particles with px > 0 walk out of the aperture"""
+    sim = ImpactX()
+
+    sim.particle_shape = 2
+    sim.space_charge = False
+    sim.slice_step_diagnostics = False
+    sim.diagnostics = False
+    sim.init_grids()
+
+    ref = sim.particle_container().ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(2.0e3)
+
+    sim.lattice.extend(
+        [
+            elements.Drift(ds=1.0),
+            elements.Aperture(xmax=1.0e-3, ymax=1.0e-3, shape="rectangular"),
+        ]
+    )
+    return sim
+
+
+def test_dynamic_aperture():
+    """
+    Survival turns of a grid of initial amplitudes
+    """
+    sim = make_sim()
+
+    turns = 5
+    survived = sim.dynamic_aperture(
+        x=[0.5e-4, 5.5e-4, 2.0e-3], y=[0.0, 2.0e-3], turns=turns, px=1.0e-4
+    )
+
+    # x after period p: x0 + (p + 1) * 1e-4
+    assert survived.shape == (3, 2)
+    assert np.array_equal(survived[:, 0], [turns, 4, 0])
+    assert np.array_equal(survived[:, 1], [0, 0, 0])
+
+    # the lost particles remember the period in which they were lost
+    df_lost = sim.particle_container_lost().to_df(local=True)
+    assert "period_lost" in df_lost.columns
+    assert len(df_lost) == 5
+
+    # finalize simulation
+    sim.finalize()
+
+
+def test_stop_when_all_lost():
+    """
+    Tracking stops after the period in which all particles were lost
+    """
+    sim = make_sim()
+
+    survived = sim.dynamic_aperture(x=[2.0e-3], y=[0.0], turns=100)
+    assert np.array_equal(survived, [[0]])
+
+    # only the first period was tracked
+    ref = sim.particle_container().ref_particle()
+    assert math.isclose(ref.s, 1.0)
+
+    # finalize simulation
+    sim.finalize()
+
+
+if __name__ == "__main__":
+    test_dynamic_aperture()
+    test_stop_when_all_lost()
+
+    # clean simulation shutdown
+    amr.finalize()
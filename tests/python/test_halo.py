@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# Authors: Axel Huebl
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import math
+
+from impactx import ImpactX, amr, distribution
+
+
+def test_halo_characteristics():
+    """
+    Halo characteristics of a Gaussian beam
+    """
+    sim = ImpactX()
+
+    sim.particle_shape = 2
+    sim.space_charge = False
+    sim.slice_step_diagnostics = False
+    sim.init_grids()
+
+    # init particle beam
+    kin_energy_MeV = 2.0e3
+    bunch_charge_C = 1.0e-9
+    npart = 100000
+
+    #   reference particle
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(kin_energy_MeV)
+
+    #   particle bunch
+    distr = distribution.Gaussian(
+        lambdaX=3.9984884770e-5,
+        lambdaY=3.9984884770e-5,
+        lambdaT=1.0e-3,
+        lambdaPx=2.6623538760e-5,
+        lambdaPy=2.6623538760e-5,
+        lambdaPt=2.0e-3,
+        muxpx=-0.846574929020762,
+        muypy=0.846574929020762,
+        mutpt=0.0,
+    )
+    sim.add_particles(bunch_charge_C, distr, npart)
+
+    rbc = pc.reduced_beam_characteristics()
+    halo = pc.halo_characteristics([0.5, 0.9])
+
+    for r, p in [("x", "px"), ("y", "py"), ("t", "pt")]:
+        # Gaussian: kurtosis of 3, fraction f within 2J/emittance <= -2 ln(1-f)
+        assert math.isclose(halo[f"kurtosis_{r}"], 3.0, rel_tol=0.05)
+        assert math.isclose(halo[f"kurtosis_{p}"], 3.0, rel_tol=0.05)
+        for f, percent in [(0.5, "50"), (0.9, "90")]:
+            assert math.isclose(
+                halo[f"emittance_{r}_{percent}"],
+                -2.0 * math.log(1.0 - f) * rbc[f"emittance_{r}"],
+                rel_tol=0.05,
+            )
+
+    # finalize simulation
+    sim.finalize()
+
+
+if __name__ == "__main__":
+    test_halo_characteristics()
+
+    # clean simulation shutdown
+    amr.finalize()
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# Authors: Axel Huebl
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import math
+
+import numpy as np
+
+from impactx import ImpactX, amr, distribution
+
+
+def test_histograms():
+    """
+    Compute 1D and 2D histograms of the beam in ImpactX
+    """
+    sim = ImpactX()
+
+    sim.particle_shape = 2
+    sim.space_charge = False
+    sim.slice_step_diagnostics = False
+    sim.init_grids()
+
+    # init particle beam
+    kin_energy_MeV = 2.0e3
+    bunch_charge_C = 1.0e-9
+    npart = 10000
+
+    #   reference particle
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(kin_energy_MeV)
+
+    #   particle bunch
+    distr = distribution.Waterbag(
+        lambdaX=3.9984884770e-5,
+        lambdaY=3.9984884770e-5,
+        lambdaT=1.0e-3,
+        lambdaPx=2.6623538760e-5,
+        lambdaPy=2.6623538760e-5,
+        lambdaPt=2.0e-3,
+        muxpx=-0.846574929020762,
+        muypy=0.846574929020762,
+        mutpt=0.0,
+    )
+    sim.add_particles(bunch_charge_C, distr, npart)
+
+    rbc = pc.reduced_beam_characteristics()
+
+    (xpx, (x_edges, px_edges)), (t, (t_edges,)) = pc.histograms(
+        [["position_x", "momentum_x"], ["position_t"]], bins=32
+    )
+
+    # automatic ranges span all particles
+    assert xpx.shape == (32, 32)
+    assert t.shape == (32,)
+    assert len(x_edges) == 33 and len(px_edges) == 33
+    assert math.isclose(x_edges[0], rbc["x_min"])
+    assert math.isclose(x_edges[-1], rbc["x_max"])
+    assert math.isclose(t_edges[-1], rbc["t_max"])
+
+    # all particles are counted: weights sum to the number of physical particles
+    w_sum = bunch_charge_C / 1.602176634e-19
+    assert math.isclose(np.sum(xpx), w_sum, rel_tol=1.0e-8)
+    assert math.isclose(np.sum(t), w_sum, rel_tol=1.0e-8)
+
+    # macro particle counts in a fixed range around the center
+    ((x_counts, (x_edges,)),) = pc.histograms(
+        [["position_x"]],
+        bins=2,
+        ranges=[[(0.0, rbc["x_max"])]],
+        weighted=False,
+    )
+    assert np.all(x_counts >= 0)
+    assert np.sum(x_counts) < npart
+    assert x_edges[0] == 0.0
+
+    # finalize simulation
+    sim.finalize()
+
+
+if __name__ == "__main__":
+    test_histograms()
+
+    # clean simulation shutdown
+    amr.finalize()
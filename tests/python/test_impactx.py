@@ -75,6 +75,72 @@ def test_impactx_fodo_file():
     sim.finalize()
 
 
+def test_impactx_history():
+    """
+    This tests the in-memory history of reduced beam characteristics
+    """
+    sim = ImpactX()
+
+    sim.load_inputs_file(basepath + "/examples/fodo/input_fodo.in")
+    sim.diagnostics = False
+    sim.slice_step_diagnostics = True
+    sim.diag_history = ["emittance_x", "beta_x"]
+
+    sim.init_grids()
+    sim.init_beam_distribution_from_inputs()
+    sim.init_lattice_elements_from_inputs()
+
+    sim.track_particles()
+
+    # initial step plus one entry per slice step
+    history = sim.history
+    assert sorted(history.keys()) == ["beta_x", "emittance_x", "s", "step"]
+    num_steps = len(history["step"])
+    assert num_steps > 1
+    assert all(len(v) == num_steps for v in history.values())
+    assert np.all(np.diff(history["s"]) >= 0.0)
+
+    # the last entry is the final state of the beam
+    rbc = sim.particle_container().reduced_beam_characteristics()
+    assert history["emittance_x"][-1] == pytest.approx(rbc["emittance_x"])
+    assert history["beta_x"][-1] == pytest.approx(rbc["beta_x"])
+
+    sim.clear_history()
+    assert len(sim.history) == 0
+
+    # finalize simulation
+    sim.finalize()
+
+
+def test_impactx_history_unique():
+    """
+    This tests that repeated history quantities are recorded once
+    """
+    sim = ImpactX()
+
+    sim.load_inputs_file(basepath + "/examples/fodo/input_fodo.in")
+    sim.diagnostics = False
+    sim.slice_step_diagnostics = True
+    sim.diag_history = ["beta_x", "all", "s", "beta_x"]
+
+    sim.init_grids()
+    sim.init_beam_distribution_from_inputs()
+    sim.init_lattice_elements_from_inputs()
+
+    sim.track_particles()
+
+    # all reduced beam characteristics, plus step and s
+    history = sim.history
+    rbc = sim.particle_container().reduced_beam_characteristics()
+    assert sorted(history.keys()) == sorted(set(rbc.keys()) | {"step", "s"})
+    num_steps = len(history["step"])
+    assert num_steps > 1
+    assert all(len(v) == num_steps for v in history.values())
+
+    # finalize simulation
+    sim.finalize()
+
+
 def test_impactx_nofile():
     """
     This tests using ImpactX without an inputs file
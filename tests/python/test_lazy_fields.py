@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import math
+
+import numpy as np
+
+from impactx import ImpactX, distribution, elements
+
+
+def setup(space_charge):
+    """Initialize a simulation of an expanding beam, returns the simulation"""
+    sim = ImpactX()
+
+    sim.n_cell = [16, 16, 16]
+    sim.particle_shape = 2
+    sim.space_charge = space_charge
+    sim.poisson_solver = "fft"
+    sim.dynamic_size = True
+    sim.prob_relative = [1.1]
+    sim.slice_step_diagnostics = False
+    sim.diagnostics = False
+    sim.init_grids()
+
+    ref = sim.particle_container().ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(250.0)
+
+    distr = distribution.Kurth6D(
+        lambdaX=4.472135955e-4,
+        lambdaY=4.472135955e-4,
+        lambdaT=9.12241869e-7,
+        lambdaPx=0.0,
+        lambdaPy=0.0,
+        lambdaPt=0.0,
+    )
+    sim.add_particles(1.0e-9, distr, 10000)
+
+    sim.lattice.append(elements.Drift(name="d1", ds=1.0, nslice=10))
+    return sim
+
+
+def deposited_charge(sim):
+    """Deposit the beam charge, returns its sum over the mesh in C"""
+    sim.deposit_charge()
+    rho = sim.rho(lev=0)
+    dV = np.prod(sim.Geom(lev=0).data().CellSize())
+    return dV * rho.sum_unique(comp=0, local=False)
+
+
+def test_fields_without_space_charge():
+    """
+    Without space charge, the fields are allocated on first access
+    """
+    sim = setup(space_charge=False)
+    sim.track_particles()
+
+    assert math.isclose(deposited_charge(sim), -1.0e-9, rel_tol=1.0e-8)
+    assert sim.phi(lev=0).n_comp == 1
+
+    sim.finalize()
+
+
+def test_space_charge_after_init_grids():
+    """
+    Enabling space charge after init_grids allocates the fields for tracking
+    """
+    sim = setup(space_charge=True)
+    sim.track_particles()
+    reference = sim.particle_container().reduced_beam_characteristics()
+    sim.finalize()
+
+    sim = setup(space_charge=False)
+    sim.space_charge = True
+    sim.track_particles()
+    rbc = sim.particle_container().reduced_beam_characteristics()
+
+    assert sim.particle_container().total_number_of_particles() == 10000
+    assert math.isclose(deposited_charge(sim), -1.0e-9, rel_tol=1.0e-8)
+    # space charge expands the beam the same way
+    for key in ["sig_x", "sig_y", "sig_t", "emittance_x", "emittance_y", "emittance_t"]:
+        assert np.isclose(rbc[key], reference[key], rtol=1.0e-10, atol=0), key
+
+    sim.finalize()
+
+
+if __name__ == "__main__":
+    test_fields_without_space_charge()
+    test_space_charge_after_init_grids()
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import numpy as np
+
+from impactx import ImpactX, distribution, elements
+
+columns = [
+    "position_x",
+    "position_y",
+    "position_t",
+    "momentum_x",
+    "momentum_y",
+    "momentum_t",
+]
+
+
+def track(make_element, charge_qe, mass_MeV, kin_energy_MeV, **integration):
+    """Track a beam through one element, returns the beam and reference particle"""
+    sim = ImpactX()
+
+    sim.particle_shape = 2
+    sim.space_charge = False
+    sim.slice_step_diagnostics = False
+    sim.diagnostics = False
+    sim.init_grids()
+
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(charge_qe).set_mass_MeV(mass_MeV).set_kin_energy_MeV(
+        kin_energy_MeV
+    )
+
+    distr = distribution.Waterbag(
+        lambdaX=1.0e-3,
+        lambdaY=1.0e-3,
+        lambdaT=1.0e-3,
+        lambdaPx=1.0e-3,
+        lambdaPy=1.0e-3,
+        lambdaPt=1.0e-3,
+    )
+    sim.add_particles(1.0e-9, distr, 100)
+
+    sim.lattice.append(make_element(nslice=4, **integration))
+    sim.track_particles()
+
+    beam = pc.to_df(local=True).sort_values("idcpu").reset_index(drop=True)
+    ref = pc.ref_particle()
+    ref_state = np.array([ref.t, ref.pt])
+
+    sim.finalize()
+    return beam, ref_state
+
+
+def errors(make_element, *particle):
+    """Deviation from many fixed steps, with few fixed steps and with map_tolerance"""
+    beam_ref, ref_state_ref = track(make_element, *particle, mapsteps=2000)
+    beam_coarse, ref_state_coarse = track(make_element, *particle, mapsteps=1)
+    beam_tol, ref_state_tol = track(make_element, *particle, map_tolerance=1.0e-9)
+
+    def error(beam, ref_state):
+        # relative to the beam size, which the element does not change much
+        beam_error = max(
+            np.max(np.abs(beam[c] - beam_ref[c])) / beam_ref[c].std() for c in columns
+        )
+        ref_error = np.max(np.abs(ref_state - ref_state_ref) / np.abs(ref_state_ref))
+        return max(beam_error, ref_error)
+
+    return error(beam_coarse, ref_state_coarse), error(beam_tol, ref_state_tol)
+
+
+def check(make_element, *particle):
+    error_coarse, error_tol = errors(make_element, *particle)
+    print(f"error with mapsteps=1: {error_coarse}, with map_tolerance: {error_tol}")
+    assert error_tol < 1.0e-4
+    assert error_tol < error_coarse
+
+
+def test_map_tolerance_rfcavity():
+    """
+    Integration steps placed by map_tolerance agree with many fixed steps in an RF cavity
+    """
+
+    def rf(**kwargs):
+        return elements.RFCavity(
+            ds=1.31879807,
+            escale=62.0,
+            freq=1.3e9,
+            phase=85.5,
+            cos_coefficients=[
+                0.1644024074311037,
+                -0.1324009958969339,
+                4.3443060026047219e-002,
+                8.5602654094946495e-002,
+                -0.2433578169042885,
+                0.5297150596779437,
+                0.7164884680963959,
+                -5.2579522442877296e-003,
+                -5.5025369142193678e-002,
+                4.6845673335028933e-002,
+                -2.3279346335638568e-002,
+                4.0800777539657775e-003,
+                4.1378326533752169e-003,
+                -2.5040533340490805e-003,
+                -4.0654981400000964e-003,
+                9.6630592067498289e-003,
+                -8.5275895985990214e-003,
+                -5.8078747006425020e-002,
+                -2.4044337836660403e-002,
+                1.0968240064697212e-002,
+                -3.4461179858301418e-003,
+                -8.1201564869443749e-004,
+                2.1438992904959380e-003,
+                -1.4997753525697276e-003,
+                1.8685171825676386e-004,
+            ],
+            sin_coefficients=[0] * 25,
+            **kwargs,
+        )
+
+    check(rf, -1.0, 0.510998950, 230.0)
+
+
+def test_map_tolerance_soft_solenoid():
+    """
+    Integration steps placed by map_tolerance agree with many fixed steps in a soft-edge solenoid
+    """
+
+    def sol(**kwargs):
+        return elements.SoftSolenoid(
+            ds=6.0,
+            bscale=1.233482899483985,
+            cos_coefficients=[
+                0.350807812299706,
+                0.323554693720069,
+                0.260320578919415,
+                0.182848575294969,
+                0.106921016050403,
+            ],
+            sin_coefficients=[0, 0, 0, 0, 0],
+            **kwargs,
+        )
+
+    check(sol, 1.0, 938.27208816, 250.0)
+
+
+def test_map_tolerance_soft_quadrupole():
+    """
+    Integration steps placed by map_tolerance agree with many fixed steps in a soft-edge quadrupole
+    """
+
+    def quad(**kwargs):
+        # a bell-shaped gradient profile
+        return elements.SoftQuadrupole(
+            ds=1.0,
+            gscale=1.0,
+            cos_coefficients=[
+                0.350807812299706,
+                0.323554693720069,
+                0.260320578919415,
+                0.182848575294969,
+                0.106921016050403,
+            ],
+            sin_coefficients=[0, 0, 0, 0, 0],
+            **kwargs,
+        )
+
+    check(quad, -1.0, 0.510998950, 2.0e3)
+
+
+if __name__ == "__main__":
+    test_map_tolerance_rfcavity()
+    test_map_tolerance_soft_solenoid()
+    test_map_tolerance_soft_quadrupole()
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import numpy as np
+
+from impactx import ImpactX, distribution, elements
+
+
+def track(numa_options):
+    """Track a FODO cell, returns the final beam"""
+    sim = ImpactX()
+
+    sim.particle_shape = 2
+    sim.space_charge = False
+    sim.slice_step_diagnostics = False
+    sim.diagnostics = False
+    sim.report_affinity = numa_options
+    sim.particle_huge_pages = numa_options
+    sim.init_grids()
+
+    assert sim.report_affinity == numa_options
+    assert sim.particle_huge_pages == numa_options
+
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(2.0e3)
+
+    distr = distribution.Waterbag(
+        lambdaX=3.9984884770e-5,
+        lambdaY=3.9984884770e-5,
+        lambdaT=1.0e-3,
+        lambdaPx=2.6623538760e-5,
+        lambdaPy=2.6623538760e-5,
+        lambdaPt=2.0e-3,
+    )
+    sim.add_particles(1.0e-9, distr, 10000)
+
+    sim.lattice.extend(
+        [
+            elements.Drift(name="d1", ds=0.25),
+            elements.Quad(name="q1", ds=1.0, k=1.0),
+            elements.Drift(name="d2", ds=0.5),
+            elements.Quad(name="q2", ds=1.0, k=-1.0),
+            elements.Drift(name="d3", ds=0.25),
+        ]
+    )
+    sim.track_particles()
+
+    beam = pc.to_df(local=True).sort_values("idcpu").reset_index(drop=True)
+    sim.finalize()
+    return beam
+
+
+def test_numa():
+    """
+    Huge pages and the affinity report do not change the beam
+    """
+    beam = track(False)
+    beam_numa = track(True)
+
+    assert len(beam_numa) == len(beam)
+    for column in [
+        "position_x",
+        "position_y",
+        "position_t",
+        "momentum_x",
+        "momentum_y",
+        "momentum_t",
+        "qm",
+        "weighting",
+    ]:
+        assert np.array_equal(beam[column], beam_numa[column]), column
+
+
+if __name__ == "__main__":
+    test_numa()
@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import numpy as np
+
+from impactx import ImpactX, distribution, elements
+
+
+def test_parallel_for_particles():
+    """
+    Pushes and beam moments with one particle tile split across OpenMP threads
+    """
+    sim = ImpactX()
+
+    # one box: fewer tiles than threads, each tile is split per thread
+    sim.particle_shape = 2
+    sim.space_charge = False
+    sim.slice_step_diagnostics = False
+    sim.diagnostics = False
+    sim.init_grids()
+
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(2.0e3)
+
+    distr = distribution.Waterbag(
+        lambdaX=1.0e-3,
+        lambdaY=1.0e-3,
+        lambdaT=1.0e-3,
+        lambdaPx=1.0e-3,
+        lambdaPy=1.0e-3,
+        lambdaPt=1.0e-3,
+        muxpx=0.5,
+    )
+    npart = 10001
+    sim.add_particles(1.0e-9, distr, npart)
+
+    sim.lattice.append(elements.Drift(ds=1.0))
+
+    before = pc.to_df(local=True).sort_values("idcpu").reset_index(drop=True)
+    sim.track_particles()
+    after = pc.to_df(local=True).sort_values("idcpu").reset_index(drop=True)
+
+    # every particle is pushed exactly once
+    assert len(after) == npart
+    assert np.allclose(
+        after["position_x"],
+        before["position_x"] + before["momentum_x"],
+        rtol=1.0e-12,
+        atol=0,
+    )
+    assert np.array_equal(after["momentum_x"], before["momentum_x"])
+
+    # moments reduced over the particle ranges of all threads
+    rbc = pc.reduced_beam_characteristics()
+    x = after["position_x"].to_numpy()
+    px = after["momentum_x"].to_numpy()
+    assert rbc["x_min"] == x.min()
+    assert rbc["x_max"] == x.max()
+    # the mean can be close to zero: compare relative to the beam size
+    assert np.isclose(rbc["x_mean"], x.mean(), rtol=0, atol=1.0e-12 * x.std())
+    assert np.isclose(rbc["sig_x"], x.std(), rtol=1.0e-10, atol=0)
+    cov = np.cov(x, px, bias=True)
+    assert np.isclose(
+        rbc["emittance_x"],
+        np.sqrt(cov[0, 0] * cov[1, 1] - cov[0, 1] ** 2),
+        rtol=1.0e-8,
+        atol=0,
+    )
+
+    sim.finalize()
+
+
+if __name__ == "__main__":
+    test_parallel_for_particles()
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import numpy as np
+
+from impactx import ImpactX, distribution, elements
+
+
+def test_probe_particles():
+    """
+    Trajectories of probe particles selected by id and by largest amplitude
+    """
+    sim = ImpactX()
+
+    sim.particle_shape = 2
+    sim.space_charge = False
+    sim.diagnostics = True
+    sim.slice_step_diagnostics = False
+    sim.init_grids()
+
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(2.0e3)
+
+    distr = distribution.Waterbag(
+        lambdaX=3.9984884770e-5,
+        lambdaY=3.9984884770e-5,
+        lambdaT=1.0e-3,
+        lambdaPx=2.6623538760e-5,
+        lambdaPy=2.6623538760e-5,
+        lambdaPt=2.0e-3,
+    )
+    npart = 1000
+    sim.add_particles(1.0e-9, distr, npart)
+
+    probe_ids = [5, 1, 5, npart]
+    sim.diag_probe_ids = probe_ids
+    sim.diag_probe_largest_amplitude = 2
+
+    # 13 slice steps
+    sim.lattice.extend(
+        [
+            elements.Drift(name="d1", ds=0.25, nslice=2),
+            elements.Quad(name="q1", ds=1.0, k=1.0, nslice=4),
+            elements.Drift(name="d2", ds=0.5, nslice=3),
+            elements.Quad(name="q2", ds=1.0, k=-1.0, nslice=4),
+        ]
+    )
+    sim.track_particles()
+
+    # written by the I/O rank 0
+    with open("diags/probe_particles.0") as f:
+        assert f.readline().split() == "id cpu step s x y t px py pt".split()
+    probes = np.loadtxt("diags/probe_particles.0", skiprows=1, ndmin=2)
+    ids = probes[:, 0].astype(int)
+    cpus = probes[:, 1].astype(int)
+
+    # requested ids once each, plus up to two by amplitude
+    unique_ids = np.unique(ids)
+    assert set(probe_ids) <= set(unique_ids)
+    assert 3 <= len(unique_ids) <= 5
+
+    # one process: all particles were created on rank 0
+    assert np.all(cpus == 0)
+
+    # sorted by id, cpu and step, initial step plus one line per slice step
+    assert np.all(np.diff(ids) >= 0)
+    for i in unique_ids:
+        steps = probes[ids == i, 2]
+        assert np.array_equal(steps, np.arange(14))
+    assert np.isclose(probes[-1, 3], 2.75, rtol=1.0e-12, atol=0)
+
+    # the last line per probe is the final particle state
+    beam = pc.to_df(local=True)
+    # particle id: bits 24-62 of idcpu, creating rank: bits 0-23
+    beam_idcpu = beam["idcpu"].to_numpy()
+    beam_ids = (beam_idcpu >> np.uint64(24)) & np.uint64(0x7FFFFFFFFF)
+    beam_cpus = beam_idcpu & np.uint64(0xFFFFFF)
+    for i in unique_ids:
+        final = probes[ids == i][-1, 4:]
+        particle = beam[(beam_ids == i) & (beam_cpus == 0)]
+        assert len(particle) == 1
+        for column, value in zip(
+            [
+                "position_x",
+                "position_y",
+                "position_t",
+                "momentum_x",
+                "momentum_y",
+                "momentum_t",
+            ],
+            final,
+        ):
+            assert np.isclose(particle[column].iloc[0], value, rtol=1.0e-12, atol=0)
+
+    sim.finalize()
+
+
+if __name__ == "__main__":
+    test_probe_particles()
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# Authors: Axel Huebl
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import numpy as np
+
+from impactx import ImpactX, distribution, elements
+
+
+def track(cache_reference_orbit):
+    """Track three periods of a soft-edge solenoid and quadrupole, returns the beam, reference particle and cache counters"""
+    sim = ImpactX()
+
+    sim.particle_shape = 2
+    sim.space_charge = False
+    sim.slice_step_diagnostics = False
+    sim.diagnostics = False
+    sim.cache_reference_orbit = cache_reference_orbit
+    sim.periods = 3
+    sim.init_grids()
+
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(1.0).set_mass_MeV(938.27208816).set_kin_energy_MeV(250.0)
+
+    distr = distribution.Waterbag(
+        lambdaX=1.0e-3,
+        lambdaY=1.0e-3,
+        lambdaT=1.0e-3,
+        lambdaPx=1.0e-3,
+        lambdaPy=1.0e-3,
+        lambdaPt=1.0e-3,
+    )
+    sim.add_particles(1.0e-9, distr, 100)
+
+    sim.lattice.extend(
+        [
+            elements.SoftSolenoid(
+                ds=6.0,
+                bscale=1.233482899483985,
+                cos_coefficients=[
+                    0.350807812299706,
+                    0.323554693720069,
+                    0.260320578919415,
+                    0.182848575294969,
+                    0.106921016050403,
+                ],
+                sin_coefficients=[0, 0, 0, 0, 0],
+                mapsteps=200,
+                nslice=4,
+            ),
+            elements.SoftQuadrupole(
+                ds=1.0,
+                gscale=0.1,
+                cos_coefficients=[2],
+                sin_coefficients=[0],
+                mapsteps=200,
+                nslice=4,
+            ),
+        ]
+    )
+    sim.track_particles()
+
+    beam = pc.to_df(local=True).sort_values("idcpu").reset_index(drop=True)
+    ref = pc.ref_particle()
+    ref_state = np.array([ref.s, ref.x, ref.y, ref.z, ref.t, ref.px, ref.py, ref.pz, ref.pt])
+    counters = (sim.ref_orbit_cache_hits, sim.ref_orbit_cache_misses)
+
+    sim.finalize()
+    return beam, ref_state, counters
+
+
+def test_ref_orbit_cache():
+    """
+    Replaying the reference orbit in later periods does not change the results
+    """
+    beam, ref_state, counters = track(False)
+    beam_cached, ref_state_cached, counters_cached = track(True)
+
+    assert counters == (0, 0)
+    # the first period fills the cache, later periods replay it
+    hits, misses = counters_cached
+    assert misses > 0
+    assert hits > 0
+
+    assert np.allclose(ref_state, ref_state_cached, rtol=1.0e-12, atol=1.0e-12)
+
+    for column in [
+        "position_x",
+        "position_y",
+        "position_t",
+        "momentum_x",
+        "momentum_y",
+        "momentum_t",
+    ]:
+        assert np.allclose(beam[column], beam_cached[column], rtol=1.0e-10)
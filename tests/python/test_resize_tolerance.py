@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import math
+
+import numpy as np
+
+from impactx import ImpactX, distribution, elements
+
+
+def test_resize_tolerance():
+    """
+    An expanding beam with space charge keeps all particles on a mesh that is
+    resized only once the beam leaves it
+    """
+    sim = ImpactX()
+
+    sim.n_cell = [16, 16, 16]
+    sim.particle_shape = 2
+    sim.space_charge = True
+    sim.poisson_solver = "fft"
+    sim.dynamic_size = True
+    sim.prob_relative = [1.1]
+    # large: the new extent is always close enough to the current one
+    sim.resize_tolerance = 0.5
+    sim.slice_step_diagnostics = False
+    sim.diagnostics = False
+    sim.init_grids()
+
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(250.0)
+
+    distr = distribution.Kurth6D(
+        lambdaX=4.472135955e-4,
+        lambdaY=4.472135955e-4,
+        lambdaT=9.12241869e-7,
+        lambdaPx=0.0,
+        lambdaPy=0.0,
+        lambdaPt=0.0,
+    )
+    npart = 10000
+    sim.add_particles(1.0e-9, distr, npart)
+
+    # the beam expands by a factor of a few
+    sim.lattice.append(elements.Drift(name="d1", ds=6.0, nslice=40))
+    sim.track_particles()
+
+    assert pc.total_number_of_particles() == npart
+    assert sim.particle_container_lost().total_number_of_particles() == 0
+
+    sim.deposit_charge()
+    rho = sim.rho(lev=0)
+    dV = np.prod(sim.Geom(lev=0).data().CellSize())
+    beam_charge = dV * rho.sum_unique(comp=0, local=False)
+    assert math.isclose(beam_charge, -1.0e-9, rel_tol=1.0e-8)
+
+    sim.finalize()
+
+
+if __name__ == "__main__":
+    test_resize_tolerance()
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import numpy as np
+from conftest import basepath
+
+from impactx import ImpactX
+
+
+def track(csr_bins):
+    """Track through a chicane with CSR wakefields, returns the final beam moments"""
+    sim = ImpactX()
+
+    sim.n_cell = [16, 24, 32]
+    sim.load_inputs_file(basepath + "/examples/chicane/input_chicane_csr.in")
+    sim.csr_bins = csr_bins
+    sim.slice_step_diagnostics = False
+    sim.diagnostics = False
+
+    sim.init_grids()
+    sim.init_beam_distribution_from_inputs()
+    sim.init_lattice_elements_from_inputs()
+    sim.track_particles()
+
+    rbc = sim.particle_container().reduced_beam_characteristics()
+
+    sim.finalize()
+    return rbc
+
+
+def test_scratch_memory():
+    """
+    Wakefield buffers reused from the scratch memory pools, over many slice steps
+    and simulations in one process, do not change the results
+    """
+    first = track(150)
+    # buffers of other sizes in between
+    track(100)
+    second = track(150)
+
+    # the order of atomic additions into the charge bins may differ
+    for key in ["sig_x", "sig_y", "sig_t", "emittance_x", "emittance_y", "emittance_t"]:
+        assert np.isclose(second[key], first[key], rtol=1.0e-10, atol=0), key
+    for d in ["x", "y", "t"]:
+        assert np.isclose(
+            second[f"{d}_mean"],
+            first[f"{d}_mean"],
+            rtol=0,
+            atol=1.0e-10 * first[f"sig_{d}"],
+        ), d
+
+
+if __name__ == "__main__":
+    test_scratch_memory()
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# Authors: Axel Huebl
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import numpy as np
+
+from impactx import ImpactX, distribution, elements
+
+
+def track(simplify):
+    """Track a short line with no-op and mergeable elements, returns the beam, lattice length and number of steps"""
+    sim = ImpactX()
+
+    sim.particle_shape = 2
+    sim.space_charge = False
+    sim.slice_step_diagnostics = False
+    sim.diagnostics = False
+    sim.diag_history = ["s"]
+    sim.simplify_lattice = simplify
+    sim.init_grids()
+
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(2.0e3)
+
+    distr = distribution.Waterbag(
+        lambdaX=1.0e-3,
+        lambdaY=1.0e-3,
+        lambdaT=1.0e-3,
+        lambdaPx=1.0e-3,
+        lambdaPy=1.0e-3,
+        lambdaPt=1.0e-3,
+    )
+    sim.add_particles(1.0e-9, distr, 100)
+
+    sim.lattice.extend(
+        [
+            elements.Marker("start"),
+            elements.Drift(ds=0.25, dx=1.0e-3),
+            elements.Drift(ds=0.75, nslice=3),
+            elements.Multipole(multipole=3, K_normal=0.0, K_skew=0.0),
+            elements.Multipole(multipole=3, K_normal=1.0, K_skew=0.0),
+            elements.Multipole(multipole=3, K_normal=2.0, K_skew=0.5),
+            elements.Empty(),
+            elements.Quad(ds=0.5, k=1.0),
+            elements.Drift(ds=0.0),
+            elements.Drift(ds=1.0),
+            elements.Marker("end"),
+        ]
+    )
+    sim.track_particles()
+
+    beam = pc.to_df(local=True).sort_values("idcpu").reset_index(drop=True)
+    num_elements = len(sim.lattice)
+    num_steps = sim.history["step"][-1]
+
+    sim.finalize()
+    return beam, num_elements, num_steps
+
+
+def test_simplify_lattice():
+    """
+    Simplifying the lattice merges drifts and multipoles without changing the beam
+    """
+    beam, num_elements, num_steps = track(False)
+    beam_simplified, num_elements_simplified, num_steps_simplified = track(True)
+
+    assert num_elements == 11
+    # drift, multipole, quad, drift
+    assert num_elements_simplified == 4
+    # without collective effects and slice step diagnostics, merged drifts are pushed in one slice
+    assert num_steps_simplified == 4
+    assert num_steps_simplified < num_steps
+
+    for column in [
+        "position_x",
+        "position_y",
+        "position_t",
+        "momentum_x",
+        "momentum_y",
+        "momentum_t",
+    ]:
+        assert np.allclose(
+            beam[column], beam_simplified[column], rtol=1.0e-12, atol=0
+        )
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+from impactx import ImpactX, distribution, elements
+
+
+def track():
+    """Track through a lattice with the same beam monitor twice, returns the slice moments file"""
+    sim = ImpactX()
+
+    sim.particle_shape = 2
+    sim.space_charge = False
+    sim.diagnostics = True
+    sim.slice_step_diagnostics = False
+    sim.init_grids()
+
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(2.0e3)
+
+    distr = distribution.Waterbag(
+        lambdaX=3.9984884770e-5,
+        lambdaY=3.9984884770e-5,
+        lambdaT=1.0e-3,
+        lambdaPx=2.6623538760e-5,
+        lambdaPy=2.6623538760e-5,
+        lambdaPt=2.0e-3,
+    )
+    sim.add_particles(1.0e-9, distr, 1000)
+
+    monitor = elements.BeamMonitor("monitor", backend="h5")
+    monitor.slice_moments = True
+    monitor.slice_bins = 8
+    sim.lattice.extend(
+        [
+            monitor,
+            elements.Drift(name="d1", ds=0.25),
+            monitor,
+        ]
+    )
+    sim.track_particles()
+
+    with open("diags/slice_moments_monitor.0") as f:
+        lines = f.read().splitlines()
+
+    sim.finalize()
+    return lines
+
+
+def test_slice_moments_output():
+    """
+    Each simulation starts a new slice moments file with one header
+    """
+    for _ in range(2):
+        lines = track()
+
+        # header, then per monitor pass: step comment and one line per slice
+        assert lines[0].startswith("# t charge_C current_A")
+        assert sum(line.startswith("# t ") for line in lines) == 1
+        assert sum(line.startswith("# step=") for line in lines) == 2
+        assert len(lines) == 1 + 2 * (1 + 8) + 1
+        assert len([line for line in lines if line and not line.startswith("#")]) == 2 * 8
+
+
+if __name__ == "__main__":
+    test_slice_moments_output()
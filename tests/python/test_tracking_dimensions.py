@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# Authors: Axel Huebl
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import numpy as np
+
+from impactx import ImpactX, amr, distribution, elements
+
+
+def track_drift(tracking_dimensions):
+    """One drift of 1 m, returns the beam before and after"""
+    sim = ImpactX()
+
+    sim.particle_shape = 2
+    sim.space_charge = False
+    sim.slice_step_diagnostics = False
+    sim.diagnostics = False
+    sim.tracking_dimensions = tracking_dimensions
+    sim.init_grids()
+
+    kin_energy_MeV = 2.0e3
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(kin_energy_MeV)
+
+    distr = distribution.Waterbag(
+        lambdaX=1.0e-3,
+        lambdaY=1.0e-3,
+        lambdaT=1.0e-3,
+        lambdaPx=1.0e-3,
+        lambdaPy=1.0e-3,
+        lambdaPt=1.0e-3,
+    )
+    sim.add_particles(1.0e-9, distr, 100)
+
+    sim.lattice.append(elements.Drift(ds=1.0))
+
+    before = pc.to_df(local=True).sort_values("idcpu").reset_index(drop=True)
+    betgam2 = ref.beta_gamma**2
+    sim.track_particles()
+    after = pc.to_df(local=True).sort_values("idcpu").reset_index(drop=True)
+
+    sim.finalize()
+    return before, after, betgam2
+
+
+def test_transverse():
+    """
+    Only x, px, y, py are pushed
+    """
+    before, after, _ = track_drift("transverse")
+
+    assert np.allclose(
+        after["position_x"],
+        before["position_x"] + before["momentum_x"],
+        rtol=1.0e-12,
+        atol=0,
+    )
+    assert np.allclose(
+        after["position_y"],
+        before["position_y"] + before["momentum_y"],
+        rtol=1.0e-12,
+        atol=0,
+    )
+    assert np.array_equal(after["position_t"], before["position_t"])
+    assert np.array_equal(after["momentum_t"], before["momentum_t"])
+
+
+def test_longitudinal():
+    """
+    Only t, pt are pushed
+    """
+    before, after, betgam2 = track_drift("longitudinal")
+
+    assert np.array_equal(after["position_x"], before["position_x"])
+    assert np.array_equal(after["position_y"], before["position_y"])
+    assert np.allclose(
+        after["position_t"],
+        before["position_t"] + before["momentum_t"] / betgam2,
+        rtol=1.0e-12,
+        atol=0,
+    )
+
+
+if __name__ == "__main__":
+    test_transverse()
+    test_longitudinal()
+
+    # clean simulation shutdown
+    amr.finalize()
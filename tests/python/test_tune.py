@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# Authors: Axel Huebl
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import math
+
+import numpy as np
+
+from impactx import ImpactX, amr, distribution, elements
+
+
+def test_tune_monitor():
+    """
+    Betatron tunes of a constant focusing ring
+    """
+    sim = ImpactX()
+
+    sim.particle_shape = 2
+    sim.space_charge = False
+    sim.slice_step_diagnostics = False
+    sim.diagnostics = False
+    sim.init_grids()
+
+    # init particle beam
+    kin_energy_MeV = 2.0e3
+    bunch_charge_C = 1.0e-9
+    npart = 1000
+
+    #   reference particle
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(kin_energy_MeV)
+
+    #   particle bunch
+    distr = distribution.Waterbag(
+        lambdaX=1.0e-3,
+        lambdaY=1.0e-3,
+        lambdaT=1.0e-3,
+        lambdaPx=1.0e-3,
+        lambdaPy=1.0e-3,
+        lambdaPt=1.0e-3,
+    )
+    sim.add_particles(bunch_charge_C, distr, npart)
+
+    # one period: constant focusing with a known phase advance
+    ds = 1.5
+    kx = 1.0
+    ky = 0.7
+    turns = 256
+    monitor = elements.TuneMonitor(name="ring", turns=turns, particle_stride=10)
+    assert monitor.turns == turns
+    assert monitor.particle_stride == 10
+
+    sim.lattice.extend([elements.ConstF(ds=ds, kx=kx, ky=ky, kt=0.5), monitor])
+    sim.periods = turns
+
+    sim.track_particles()
+
+    # columns: window step id Qx Qy
+    tunes = np.loadtxt("diags/tunes_ring.0", skiprows=1, ndmin=2)
+    assert tunes.shape[0] == npart // 10
+    assert np.all(tunes[:, 0] == 0)
+    assert np.all((tunes[:, 2] - 1) % 10 == 0)
+
+    # fractional tunes from the phase advance per turn
+    qx = kx * ds / (2.0 * math.pi)
+    qy = ky * ds / (2.0 * math.pi)
+    assert np.allclose(tunes[:, 3], qx, atol=1.0e-3)
+    assert np.allclose(tunes[:, 4], qy, atol=1.0e-3)
+
+    # finalize simulation
+    sim.finalize()
+
+
+if __name__ == "__main__":
+    test_tune_monitor()
+
+    # clean simulation shutdown
+    amr.finalize()
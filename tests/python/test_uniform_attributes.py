@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022-2024 The ImpactX Community
+#
+# License: BSD-3-Clause-LBNL
+#
+# -*- coding: utf-8 -*-
+
+import numpy as np
+
+from impactx import ImpactX, ImpactXParIter, distribution, elements
+
+
+def test_uniform_attributes():
+    """
+    Modifying the weights from Python after tracking invalidates the uniform
+    weight, so that the moments use the new weights
+    """
+    sim = ImpactX()
+
+    sim.particle_shape = 2
+    sim.space_charge = False
+    sim.slice_step_diagnostics = False
+    sim.diagnostics = False
+    sim.init_grids()
+
+    kin_energy_MeV = 2.0e3
+    bunch_charge_C = 1.0e-9
+    npart = 10000
+
+    pc = sim.particle_container()
+    ref = pc.ref_particle()
+    ref.set_charge_qe(-1.0).set_mass_MeV(0.510998950).set_kin_energy_MeV(kin_energy_MeV)
+
+    distr = distribution.Waterbag(
+        lambdaX=3.9984884770e-5,
+        lambdaY=3.9984884770e-5,
+        lambdaT=1.0e-3,
+        lambdaPx=2.6623538760e-5,
+        lambdaPy=2.6623538760e-5,
+        lambdaPt=2.0e-3,
+    )
+    sim.add_particles(bunch_charge_C, distr, npart)
+
+    sim.lattice.extend(
+        [
+            elements.Drift(name="d1", ds=0.25),
+            elements.Quad(name="q1", ds=1.0, k=1.0),
+            elements.Drift(name="d2", ds=0.25),
+        ]
+    )
+    sim.track_particles()
+
+    assert pc.uniform_weight is not None
+    assert pc.uniform_qm is not None
+    charge_before = pc.reduced_beam_characteristics()["charge_C"]
+
+    # triple the weight of all particles with x > 0
+    for lvl in range(pc.finest_level + 1):
+        for pti in ImpactXParIter(pc, level=lvl):
+            soa = pti.soa().to_xp()
+            x = soa.real["position_x"]
+            w = soa.real["weighting"]
+            w[x > 0.0] *= 3.0
+
+    assert pc.uniform_weight is None
+    assert pc.uniform_qm is None
+
+    beam = pc.to_df(local=True)
+    x = beam["position_x"].to_numpy()
+    w = beam["weighting"].to_numpy()
+    w_before = np.where(x > 0.0, w / 3.0, w)
+
+    rbc = pc.reduced_beam_characteristics()
+    assert np.isclose(
+        rbc["charge_C"], charge_before * w.sum() / w_before.sum(), rtol=1.0e-12, atol=0
+    )
+    assert np.isclose(rbc["x_mean"], np.average(x, weights=w), rtol=1.0e-10, atol=0)
+
+    # detecting the uniform values again finds the mixed weights
+    pc.update_uniform_attributes()
+    assert pc.uniform_weight is None
+    assert pc.uniform_qm is not None
+
+    sim.finalize()
+
+
+if __name__ == "__main__":
+    test_uniform_attributes()